@@ -0,0 +1,151 @@
+#ifndef _ATTACK_TABLES_H_
+#define _ATTACK_TABLES_H_
+
+#include <cstddef>
+
+#include "bitboard.h"
+
+// Tables of the cells a leaping piece can reach from each square, worked out
+// by the compiler. A piece looks up its square and masks the result with the
+// Board's occupancy, instead of trying every jump and checking that it landed
+// on the board.
+
+struct SquareTable
+{
+    Bitboard squares[BOARD_SQUARES] = {};
+
+    constexpr Bitboard operator[](int square) const { return squares[square]; }
+};
+
+struct Jump
+{
+    int x, y;
+};
+
+// The cells reached by each of jumps from every square (if they're on the board).
+template <size_t N>
+constexpr SquareTable jump_table(const Jump (&jumps)[N])
+{
+    SquareTable table;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        for (const Jump& jump : jumps)
+        {
+            int x = square % 8 + jump.x, y = square / 8 + jump.y;
+            if (x >= 0 && x < 8 && y >= 0 && y < 8)
+            {
+                table.squares[square] |= Bitboard(1) << (y * 8 + x);
+            }
+        }
+    }
+    return table;
+}
+
+// How the built in pieces get around. Boards of every size (see
+// piece_moves.h) use these, so there is only one copy of each.
+constexpr Jump KING_JUMPS[] = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+constexpr Jump KNIGHT_JUMPS[] = {{-1, 2}, {1, 2}, {-2, 1}, {2, 1}, {-2, -1}, {2, -1}, {-1, -2}, {1, -2}};
+// Rooks and bishops slide any number of cells in one of these directions.
+constexpr Jump ROOK_DIRECTIONS[] = {{0, 1}, {-1, 0}, {1, 0}, {0, -1}};
+constexpr Jump BISHOP_DIRECTIONS[] = {{-1, 1}, {1, 1}, {-1, -1}, {1, -1}};
+// A DarkKnight moves like a queen, but only up to this many cells.
+constexpr int DARK_KNIGHT_RANGE = 4;
+
+inline constexpr SquareTable KING_ATTACKS = jump_table(KING_JUMPS);
+inline constexpr SquareTable KNIGHT_ATTACKS = jump_table(KNIGHT_JUMPS);
+
+// The cells at most distance moves away for a king (not counting the square itself).
+constexpr SquareTable reach_table(int distance)
+{
+    SquareTable table;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        for (int other = 0; other < BOARD_SQUARES; ++other)
+        {
+            int dx = other % 8 - square % 8, dy = other / 8 - square / 8;
+            if (other != square && dx >= -distance && dx <= distance && dy >= -distance && dy <= distance)
+            {
+                table.squares[square] |= Bitboard(1) << other;
+            }
+        }
+    }
+    return table;
+}
+
+// The cells a DarkKnight can reach like a queen, if nothing is in the way.
+inline constexpr SquareTable DARK_KNIGHT_REACH = reach_table(DARK_KNIGHT_RANGE);
+
+// Pawns and CowardlyDogs move y_move_steps rows at a time, so their tables come
+// in one set per direction. Steps of 8 or more rows always leave the board, so
+// every longer step shares the (empty) tables for 8 rows.
+const int MAX_TABLE_STEPS = 8;
+
+inline int step_table_index(int y_move_steps)
+{
+    if (y_move_steps < -MAX_TABLE_STEPS)
+    {
+        return 0;
+    }
+    if (y_move_steps > MAX_TABLE_STEPS)
+    {
+        return 2 * MAX_TABLE_STEPS;
+    }
+    return y_move_steps + MAX_TABLE_STEPS;
+}
+
+// One SquareTable for each direction, indexed by step_table_index.
+struct StepTables
+{
+    SquareTable by_step[2 * MAX_TABLE_STEPS + 1];
+
+    constexpr const SquareTable& operator[](int table_index) const { return by_step[table_index]; }
+};
+
+// The cells steps rows ahead and jump_x columns across, for each jump_x in
+// jumps_x. With whole_file, every cell in that direction up to the edge.
+template <size_t N>
+constexpr StepTables step_tables(const int (&jumps_x)[N], bool whole_file)
+{
+    StepTables tables;
+    for (int steps = -MAX_TABLE_STEPS; steps <= MAX_TABLE_STEPS; ++steps)
+    {
+        if (steps == 0 && whole_file)
+        {
+            continue;
+        }
+        SquareTable& table = tables.by_step[steps + MAX_TABLE_STEPS];
+        for (int square = 0; square < BOARD_SQUARES; ++square)
+        {
+            for (int jump_x : jumps_x)
+            {
+                if (steps == 0 && jump_x == 0)
+                {
+                    continue; // that's the square itself
+                }
+                int x = square % 8 + jump_x;
+                for (int y = square / 8 + steps; x >= 0 && x < 8 && y >= 0 && y < 8; y += steps)
+                {
+                    table.squares[square] |= Bitboard(1) << (y * 8 + x);
+                    if (!whole_file)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    return tables;
+}
+
+constexpr int STRAIGHT_AHEAD[] = {0};
+constexpr int DIAGONALLY_AHEAD[] = {-1, 1};
+
+// The cell a pawn moves to without capturing.
+inline constexpr StepTables PAWN_PUSHES = step_tables(STRAIGHT_AHEAD, false);
+// The cells a pawn captures on.
+inline constexpr StepTables PAWN_ATTACKS = step_tables(DIAGONALLY_AHEAD, false);
+// Every cell straight ahead, for a CowardlyDog running away (it goes
+// -y_move_steps rows at a time).
+inline constexpr StepTables FILE_RAYS = step_tables(STRAIGHT_AHEAD, true);
+
+#endif // _ATTACK_TABLES_H_
@@ -0,0 +1,452 @@
+#ifndef _BASIC_BOARD_H_
+#define _BASIC_BOARD_H_
+
+#include <bitset>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "attack_tables.h"
+#include "chess_board.h"
+#include "chess_pieces.h"
+#include "piece_moves.h"
+
+// The Geometry (see piece_moves.h) of a board with Rows x Cols cells, which
+// finds where pieces can go by walking from cell to cell. Its Targets have a
+// bit for each cell, numbered y * Cols + x.
+template <int Rows, int Cols>
+class CellGeometry
+{
+public:
+    static constexpr int NUM_CELLS = Rows * Cols;
+    typedef std::bitset<static_cast<size_t>(NUM_CELLS)> Targets;
+
+    static constexpr int index_of(Cell cell) { return cell.y * Cols + cell.x; }
+    static constexpr Cell cell_at(int index) { return Cell(index % Cols, index / Cols); }
+    static constexpr bool contains(Cell cell)
+    {
+        return cell.x >= 0 && cell.x < Cols && cell.y >= 0 && cell.y < Rows;
+    }
+
+    // codes holds the code of the piece on each cell, numbered the same way.
+    explicit CellGeometry(const PieceCode* codes) : type_masks(), team_masks()
+    {
+        for (int index = 0; index < NUM_CELLS; ++index)
+        {
+            type_masks[code_type(codes[index])].set(bit(index));
+            team_masks[code_team(codes[index])].set(bit(index));
+        }
+    }
+
+    Targets empty() const { return team_masks[NONE]; }
+    Targets enemies(Team team) const
+    {
+        switch (team)
+        {
+        case WHITE:
+            return team_masks[BLACK];
+        case BLACK:
+            return team_masks[WHITE];
+        default:
+            return Targets();
+        }
+    }
+    Targets pieces(PieceType type) const { return type_masks[type]; }
+
+    static Targets king_steps(int index) { return jumps(index, KING_JUMPS); }
+    static Targets knight_jumps(int index) { return jumps(index, KNIGHT_JUMPS); }
+    Targets rook_lines(int index) const { return lines(index, ROOK_DIRECTIONS, true); }
+    Targets bishop_lines(int index) const { return lines(index, BISHOP_DIRECTIONS, true); }
+    Targets open_lines(int index) const
+    {
+        return lines(index, ROOK_DIRECTIONS, false) | lines(index, BISHOP_DIRECTIONS, false);
+    }
+    static Targets near(int index)
+    {
+        Targets targets;
+        Cell from = cell_at(index);
+        for (int y = from.y - DARK_KNIGHT_RANGE; y <= from.y + DARK_KNIGHT_RANGE; ++y)
+        {
+            for (int x = from.x - DARK_KNIGHT_RANGE; x <= from.x + DARK_KNIGHT_RANGE; ++x)
+            {
+                if (contains(Cell(x, y)) && Cell(x, y) != from)
+                {
+                    targets.set(bit(index_of(Cell(x, y))));
+                }
+            }
+        }
+        return targets;
+    }
+    static Targets pawn_push(int index, int steps)
+    {
+        const Jump ahead[] = {{0, steps}};
+        return jumps(index, ahead);
+    }
+    static Targets pawn_attacks(int index, int steps)
+    {
+        const Jump diagonally_ahead[] = {{-1, steps}, {1, steps}};
+        return jumps(index, diagonally_ahead);
+    }
+    static Targets file_run(int index, int steps)
+    {
+        Targets targets;
+        Cell from = cell_at(index);
+        for (Cell to(from.x, from.y + steps); steps != 0 && contains(to); to.y += steps)
+        {
+            targets.set(bit(index_of(to)));
+        }
+        return targets;
+    }
+
+    static bool any(const Targets& targets) { return targets.any(); }
+    static int pop_first(Targets& targets)
+    {
+        int index = 0;
+        while (!targets.test(bit(index)))
+        {
+            ++index;
+        }
+        targets.reset(bit(index));
+        return index;
+    }
+    static int count(const Targets& targets) { return static_cast<int>(targets.count()); }
+
+private:
+    static size_t bit(int index) { return static_cast<size_t>(index); }
+
+    // The cells reached by each of jumps from index (if they're on the board).
+    template <size_t N>
+    static Targets jumps(int index, const Jump (&offsets)[N])
+    {
+        Targets targets;
+        Cell from = cell_at(index);
+        for (const Jump& jump : offsets)
+        {
+            Cell to(from.x + jump.x, from.y + jump.y);
+            if (contains(to) && to != from)
+            {
+                targets.set(bit(index_of(to)));
+            }
+        }
+        return targets;
+    }
+
+    // Walks from index in each of directions to the edge of the board, or
+    // (if blocked) to the first piece on the way.
+    template <size_t N>
+    Targets lines(int index, const Jump (&directions)[N], bool blocked) const
+    {
+        Targets targets;
+        Cell from = cell_at(index);
+        for (const Jump& direction : directions)
+        {
+            for (Cell to(from.x + direction.x, from.y + direction.y); contains(to);
+                 to = Cell(to.x + direction.x, to.y + direction.y))
+            {
+                targets.set(bit(index_of(to)));
+                if (blocked && !team_masks[NONE].test(bit(index_of(to))))
+                {
+                    break;
+                }
+            }
+        }
+        return targets;
+    }
+
+    Targets type_masks[NUM_PIECE_TYPES];
+    Targets team_masks[3];
+};
+
+// A board of any size other than 8x8, for big variants like 10x10 and 12x12.
+// It is a plain array of cells (too big for a Bitboard), and its pieces move
+// by the same rules as Board's (see piece_moves.h), through a CellGeometry of
+// its size, so every loop and edge check is specialized for it.
+//
+// Only the built in pieces can go on it: custom pieces generate their moves
+// for an 8x8 Board. The searches only play on a Board, but this has the same
+// move generation, undo, hashing and move checks, so perft and anything else
+// written against those works on it.
+template <int Rows, int Cols>
+class BasicBoard
+{
+    static_assert(Rows >= 1 && Rows <= 99 && Cols >= 1 && Cols <= 26,
+                  "Board text has room for 99 rows and 26 columns");
+
+public:
+    typedef CellGeometry<Rows, Cols> Geometry;
+
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    static constexpr int NUM_CELLS = Geometry::NUM_CELLS;
+    // Room for 4 moves per cell, like a Board's MoveList. load rejects
+    // positions whose pieces could ever have more, the same way Board::load
+    // does (see MoveList and most_team_moves).
+    static constexpr int MAX_MOVES = 4 * NUM_CELLS;
+    typedef BasicMoveList<MAX_MOVES> MoveList;
+
+    // An empty board with white to move.
+    BasicBoard() : squares(), codes()
+    {
+        for (int index = 0; index < NUM_CELLS; ++index)
+        {
+            squares[index] = &EMPTY_SPACE;
+            codes[index] = EMPTY_SPACE.code;
+        }
+    }
+
+    // Where cell is in the board's arrays (and in an UndoRecord).
+    static constexpr int index_of(Cell cell) { return Geometry::index_of(cell); }
+    static constexpr Cell cell_at(int index) { return Geometry::cell_at(index); }
+    static constexpr bool contains(Cell cell) { return Geometry::contains(cell); }
+
+    const ChessPiece& operator[](Cell cell) const { return *squares[index_of(cell)]; }
+
+    MoveList get_moves() const
+    {
+        Geometry geometry(codes);
+        return get_moves_onto(geometry, ~typename Geometry::Targets());
+    }
+
+    // Only the moves from get_moves that capture a piece of the other team,
+    // in the same order.
+    MoveList get_captures() const
+    {
+        Geometry geometry(codes);
+        return get_moves_onto(geometry, geometry.enemies(current_teams_turn));
+    }
+
+    // Whether move is one of the moves get_moves would return.
+    bool is_legal(Move move) const
+    {
+        if (!contains(move.from) || !contains(move.to) || code_team(codes[index_of(move.from)]) != current_teams_turn)
+        {
+            return false;
+        }
+        int from = index_of(move.from);
+        return piece_targets(Geometry(codes), codes[from], from).test(static_cast<size_t>(index_of(move.to)));
+    }
+
+    // Every piece on this board moves the classical way, so this is
+    // Board::make_classical_chess_move plus the undo record.
+    UndoRecord make_move(Move move)
+    {
+        if (!contains(move.to) || !contains(move.from))
+        {
+            std::stringstream err_msg;
+            err_msg << "BasicBoard::make_move called with a move that moves to or from a cell that is not on the board: " << move;
+            throw std::out_of_range(err_msg.str());
+        }
+        UndoRecord undo;
+        undo.move = move;
+        undo.moved_piece = squares[index_of(move.from)];
+        undo.captured_piece = squares[index_of(move.to)];
+        undo.previous_turn = current_teams_turn;
+        undo.previous_hash = zobrist_hash;
+        undo.num_changes = 2;
+        undo.changed_squares[0] = index_of(move.to);
+        undo.previous_pieces[0] = undo.captured_piece;
+        undo.changed_squares[1] = index_of(move.from);
+        undo.previous_pieces[1] = undo.moved_piece;
+        set_square(index_of(move.to), *undo.moved_piece);
+        set_square(index_of(move.from), EMPTY_SPACE);
+        set_turn(current_teams_turn == WHITE ? BLACK : WHITE);
+        return undo;
+    }
+
+    void unmake_move(const UndoRecord& undo)
+    {
+        for (int i = undo.num_changes - 1; i >= 0; --i)
+        {
+            set_square(undo.changed_squares[i], *undo.previous_pieces[i]);
+        }
+        current_teams_turn = undo.previous_turn;
+        zobrist_hash = undo.previous_hash;
+    }
+
+    // Throws out_of_range if cell isn't on the board, and invalid_argument for
+    // a custom piece.
+    void place_piece(Cell cell, const ChessPiece& piece)
+    {
+        if (!contains(cell))
+        {
+            std::stringstream err_msg;
+            err_msg << "BasicBoard::place_piece called with a cell that is not on the board: " << cell;
+            throw std::out_of_range(err_msg.str());
+        }
+        if (code_type(piece.code) == CUSTOM_PIECE)
+        {
+            throw std::invalid_argument("Custom pieces can only go on an 8x8 Board");
+        }
+        set_square(index_of(cell), piece);
+    }
+
+    // Returns the winner or NONE if there is no winner (yet). Like Board, it
+    // counts the kings as they come and go instead of looking for them.
+    Team winner() const
+    {
+        if (king_counts[WHITE] == 0)
+        {
+            return BLACK;
+        }
+        if (king_counts[BLACK] == 0)
+        {
+            return WHITE;
+        }
+        return NONE;
+    }
+
+    Team turn() const { return current_teams_turn; }
+    void set_turn(Team team)
+    {
+        if (team != current_teams_turn)
+        {
+            current_teams_turn = team;
+            zobrist_hash ^= ZOBRIST_BLACK_TO_MOVE;
+        }
+    }
+
+    // A 64 bit Zobrist hash of the position, kept up to date like Board's
+    // (with keys for this many cells).
+    uint64_t hash() const { return zobrist_hash; }
+    // Works out the Zobrist hash from scratch.
+    uint64_t compute_hash() const
+    {
+        uint64_t hash = current_teams_turn == BLACK ? ZOBRIST_BLACK_TO_MOVE : 0;
+        for (int index = 0; index < NUM_CELLS; ++index)
+        {
+            hash ^= squares[index]->zobrist_key(index, NUM_CELLS);
+        }
+        return hash;
+    }
+
+    // Replaces every piece with the ones in text, which must be Rows x Cols
+    // with no more pieces than a MoveList has room for the moves of (or else
+    // this throws runtime_error) and have no custom pieces (or else this
+    // throws invalid_argument). Doesn't change whose turn it is.
+    void load(const BoardText& text)
+    {
+        if (text.rows != Rows || text.cols != Cols)
+        {
+            throw std::runtime_error("Chess board input is " + std::to_string(text.cols) + "x" + std::to_string(text.rows) +
+                                     ", but this board is " + std::to_string(Cols) + "x" + std::to_string(Rows) + "!");
+        }
+        const BasicBoard empty_board;
+        Geometry empty_geometry(empty_board.codes);
+        if (most_team_moves(empty_geometry, text, WHITE) > MoveList::CAPACITY ||
+            most_team_moves(empty_geometry, text, BLACK) > MoveList::CAPACITY)
+        {
+            throw std::runtime_error("Chess board input has too many pieces: they could have more moves than a MoveList holds!");
+        }
+        for (int index = 0; index < NUM_CELLS; ++index)
+        {
+            place_piece(cell_at(index), *text.cells[static_cast<size_t>(index)]);
+        }
+    }
+
+    friend void append_board(string& out, const BasicBoard& board)
+    {
+        append_board_text(out, Rows, Cols, board.squares);
+    }
+
+    friend ostream& operator<<(ostream& os, const BasicBoard& board)
+    {
+        string text;
+        append_board(text, board);
+        return os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    friend istream& operator>>(istream& is, BasicBoard& board)
+    {
+        board.load(read_board_text(is));
+        return is;
+    }
+
+private:
+    void set_square(int index, const ChessPiece& piece)
+    {
+        const ChessPiece& old_piece = *squares[index];
+        if (old_piece.type == KING)
+        {
+            --king_counts[old_piece.team];
+        }
+        if (piece.type == KING)
+        {
+            ++king_counts[piece.team];
+        }
+        zobrist_hash ^= old_piece.zobrist_key(index, NUM_CELLS) ^ piece.zobrist_key(index, NUM_CELLS);
+        squares[index] = &piece;
+        codes[index] = piece.code;
+    }
+
+    // The moves of the current team that land on one of the targets, in cell
+    // order.
+    MoveList get_moves_onto(const Geometry& geometry, const typename Geometry::Targets& targets) const
+    {
+        MoveList moves;
+        typename Geometry::Targets enemy_kings = geometry.pieces(KING) & geometry.enemies(current_teams_turn);
+        for (int from = 0; from < NUM_CELLS; ++from)
+        {
+            if (code_team(codes[from]) != current_teams_turn)
+            {
+                continue;
+            }
+            typename Geometry::Targets piece_moves = piece_targets(geometry, codes[from], from) & targets;
+            for (int to = 0; piece_moves.any(); ++to)
+            {
+                if (!piece_moves.test(static_cast<size_t>(to)))
+                {
+                    continue;
+                }
+                piece_moves.reset(static_cast<size_t>(to));
+                moves.emplace_back(cell_at(from), cell_at(to));
+                if (enemy_kings.test(static_cast<size_t>(to)) && !moves.has_king_capture)
+                {
+                    moves.has_king_capture = true;
+                    moves.king_capture_move = Move(cell_at(from), cell_at(to));
+                }
+            }
+        }
+        return moves;
+    }
+
+    const ChessPiece* squares[static_cast<size_t>(NUM_CELLS)];
+    PieceCode codes[static_cast<size_t>(NUM_CELLS)];
+    int king_counts[3] = {0, 0, 0};
+    Team current_teams_turn = WHITE;
+    uint64_t zobrist_hash = 0;
+};
+
+// Builds the BasicBoard that matches the size of text (8x8, 10x10 or 12x12)
+// and calls visit with it, so the same code can work on any of them:
+//     visit_board(read_board_text(is), [](auto& board) { cout << perft(board, 3); });
+// Throws runtime_error for any other size.
+template <typename Visitor>
+void visit_board(const BoardText& text, Visitor&& visit)
+{
+    if (text.rows == 8 && text.cols == 8)
+    {
+        Board board;
+        board.load(text);
+        visit(board);
+    }
+    else if (text.rows == 10 && text.cols == 10)
+    {
+        BasicBoard<10, 10> board;
+        board.load(text);
+        visit(board);
+    }
+    else if (text.rows == 12 && text.cols == 12)
+    {
+        BasicBoard<12, 12> board;
+        board.load(text);
+        visit(board);
+    }
+    else
+    {
+        throw std::runtime_error("There is no board for " + std::to_string(text.cols) + "x" + std::to_string(text.rows) +
+                                 " chess (try 8x8, 10x10 or 12x12)");
+    }
+}
+
+#endif // _BASIC_BOARD_H_
@@ -0,0 +1,38 @@
+#ifndef _BITBOARD_H_
+#define _BITBOARD_H_
+
+#include <cstdint>
+
+// A Bitboard is a set of cells on an 8x8 board, stored as one bit per cell.
+// Bit number (y * 8 + x) is set when Cell(x, y) is in the set, so scanning the
+// bits from lowest to highest visits the cells in the same order as looping
+// over y and then x.
+typedef uint64_t Bitboard;
+
+const int BOARD_SQUARES = 64;
+
+inline Bitboard square_bit(int square)
+{
+    return Bitboard(1) << square;
+}
+
+// Returns the index of the lowest set bit. bitboard must not be 0.
+inline int lowest_square(Bitboard bitboard)
+{
+    return __builtin_ctzll(bitboard);
+}
+
+// Removes the lowest set bit from bitboard and returns its index.
+inline int pop_lowest_square(Bitboard& bitboard)
+{
+    int square = __builtin_ctzll(bitboard);
+    bitboard &= bitboard - 1;
+    return square;
+}
+
+inline int count_squares(Bitboard bitboard)
+{
+    return __builtin_popcountll(bitboard);
+}
+
+#endif // _BITBOARD_H_
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -8,8 +9,10 @@
 #include "utf8_codepoint.h"
 #include "chess_pieces.h"
 #include "chess_board.h"
+#include "evaluation.h"
+#include "piece_moves.h"
 
-using std::endl;
+using std::find;
 using std::istream;
 using std::map;
 using std::ostream;
@@ -77,67 +80,136 @@ istream& operator>>(istream& is, Move& move)
     return is >> move.from >> move.to;
 }
 
-Board::Board()
+ostream& operator<<(ostream& os, const PackedMove& move)
+{
+    return os << move.move();
+}
+istream& operator>>(istream& is, PackedMove& move)
+{
+    Move unpacked;
+    if (is >> unpacked)
+    {
+        move = PackedMove(unpacked);
+    }
+    return is;
+}
+
+void throw_move_list_full()
+{
+    throw out_of_range("MoveList is full! A position has more moves than MoveList::CAPACITY");
+}
+
+Board::BasicBoard()
 {
-    board.resize(rows, vector<const ChessPiece* >(cols));
     reset_board();
 }
 
 const ChessPiece& Board::operator[](Cell cell) const
 {
-    return *board[cell.y][cell.x];
+    return *squares[to_square(cell)];
 }
 
-void Board::reset_board()
+void Board::clear_board()
 {
-    for (int y = 0; y < rows; ++y)
+    for (int square = 0; square < BOARD_SQUARES; ++square)
     {
-        for (int x = 0; x < cols; ++x)
+        squares[square] = &EMPTY_SPACE;
+        codes[square] = EMPTY_SPACE.code;
+    }
+    for (Bitboard& mask : piece_type_masks)
+    {
+        mask = 0;
+    }
+    for (Bitboard& mask : team_masks)
+    {
+        mask = 0;
+    }
+    piece_type_masks[NO_PIECE] = ~Bitboard(0);
+    team_masks[NONE] = ~Bitboard(0);
+    occupied = 0;
+    zobrist_hash = 0;
+    piece_square_total = 0;
+}
+
+void Board::set_square(int square, const ChessPiece& piece)
+{
+    Bitboard bit = square_bit(square);
+    const ChessPiece& old_piece = *squares[square];
+    if (undo_log)
+    {
+        if (undo_log->num_changes == UndoRecord::MAX_CHANGES)
         {
-            board[y][x] = &EMPTY_SPACE;
+            throw out_of_range("Board::set_square: a move changed more cells than an UndoRecord can hold");
         }
+        undo_log->changed_squares[undo_log->num_changes] = square;
+        undo_log->previous_pieces[undo_log->num_changes] = &old_piece;
+        ++undo_log->num_changes;
     }
+    piece_type_masks[old_piece.type] &= ~bit;
+    team_masks[old_piece.team] &= ~bit;
+    piece_type_masks[piece.type] |= bit;
+    team_masks[piece.team] |= bit;
+    occupied = team_masks[WHITE] | team_masks[BLACK];
+    zobrist_hash ^= old_piece.zobrist_key(square) ^ piece.zobrist_key(square);
+    piece_square_total += piece_square_score(piece.type, piece.team, square) -
+                          piece_square_score(old_piece.type, old_piece.team, square);
+    squares[square] = &piece;
+    codes[square] = piece.code;
+}
+
+void Board::reset_board()
+{
+    clear_board();
 
     for (int x = 0; x < cols; ++x)
     {
-        board[1][x] = &WHITE_PAWN;
-        board[6][x] = &BLACK_PAWN;
+        set_square(to_square(Cell(x, 1)), WHITE_PAWN);
+        set_square(to_square(Cell(x, 6)), BLACK_PAWN);
     }
 
-    board[0][0] = &WHITE_ROOK;
-    board[0][1] = &WHITE_KNIGHT;
-    board[0][2] = &WHITE_BISHOP;
-    board[0][3] = &WHITE_QUEEN;
-    board[0][4] = &WHITE_KING;
-    board[0][5] = &WHITE_BISHOP;
-    board[0][6] = &WHITE_KNIGHT;
-    board[0][7] = &WHITE_ROOK;
+    set_square(to_square(Cell(0, 0)), WHITE_ROOK);
+    set_square(to_square(Cell(1, 0)), WHITE_KNIGHT);
+    set_square(to_square(Cell(2, 0)), WHITE_BISHOP);
+    set_square(to_square(Cell(3, 0)), WHITE_QUEEN);
+    set_square(to_square(Cell(4, 0)), WHITE_KING);
+    set_square(to_square(Cell(5, 0)), WHITE_BISHOP);
+    set_square(to_square(Cell(6, 0)), WHITE_KNIGHT);
+    set_square(to_square(Cell(7, 0)), WHITE_ROOK);
 
-    board[7][0] = &BLACK_ROOK;
-    board[7][1] = &BLACK_KNIGHT;
-    board[7][2] = &BLACK_BISHOP;
-    board[7][3] = &BLACK_QUEEN;
-    board[7][4] = &BLACK_KING;
-    board[7][5] = &BLACK_BISHOP;
-    board[7][6] = &BLACK_KNIGHT;
-    board[7][7] = &BLACK_ROOK;
+    set_square(to_square(Cell(0, 7)), BLACK_ROOK);
+    set_square(to_square(Cell(1, 7)), BLACK_KNIGHT);
+    set_square(to_square(Cell(2, 7)), BLACK_BISHOP);
+    set_square(to_square(Cell(3, 7)), BLACK_QUEEN);
+    set_square(to_square(Cell(4, 7)), BLACK_KING);
+    set_square(to_square(Cell(5, 7)), BLACK_BISHOP);
+    set_square(to_square(Cell(6, 7)), BLACK_KNIGHT);
+    set_square(to_square(Cell(7, 7)), BLACK_ROOK);
 
     current_teams_turn = WHITE;
+    zobrist_hash = compute_hash();
 }
 
-vector<Move> Board::get_moves() const
+MoveList Board::get_moves() const
 {
-    vector<Move> moves;
-    for (int y = 0; y < rows; ++y)
+    MoveList moves;
+    BitboardGeometry geometry(*this);
+    // Visits the pieces in the same order as looping over y and then x.
+    Bitboard movers = team_masks[current_teams_turn];
+    while (movers)
     {
-        for (int x = 0; x < cols; ++x)
+        int square = pop_lowest_square(movers);
+        // The built in pieces are generated right here, and only custom
+        // pieces cost a virtual call.
+        if (code_type(codes[square]) != CUSTOM_PIECE)
         {
-            if (board[y][x]->team == current_teams_turn)
-            {
-                board[y][x]->get_moves(*this, Cell(x, y), moves);
-            }
+            add_moves(square, piece_targets(geometry, codes[square], square), moves);
+        }
+        else
+        {
+            squares[square]->get_moves(*this, to_cell(square), moves);
         }
     }
+    Bitboard enemy_kings = pieces(KING, current_teams_turn == WHITE ? BLACK : WHITE);
     for (Move move : moves)
     {
         if (!contains(move.to) || !contains(move.from))
@@ -146,10 +218,85 @@ vector<Move> Board::get_moves() const
             err_msg << "Board::get_moves got a move that moves to or from a cell that is not on the board: " << move;
             throw out_of_range(err_msg.str());
         }
+        if ((enemy_kings & square_bit(to_square(move.to))) && !moves.has_king_capture)
+        {
+            moves.has_king_capture = true;
+            moves.king_capture_move = move;
+        }
     }
     return moves;
 }
 
+MoveList Board::get_captures() const
+{
+    return get_moves_onto(enemies(*this, current_teams_turn));
+}
+
+MoveList Board::get_king_captures() const
+{
+    return get_moves_onto(enemies(*this, current_teams_turn) & piece_type_masks[KING]);
+}
+
+Bitboard Board::move_targets(int square) const
+{
+    return piece_targets(BitboardGeometry(*this), codes[square], square);
+}
+
+MoveList Board::get_moves_onto(Bitboard targets) const
+{
+    MoveList moves;
+    Bitboard movers = targets ? team_masks[current_teams_turn] : 0;
+    while (movers)
+    {
+        int square = pop_lowest_square(movers);
+        if (code_type(codes[square]) != CUSTOM_PIECE)
+        {
+            add_moves(square, move_targets(square) & targets, moves);
+            continue;
+        }
+        // Only the piece knows where it can go, so it lists all its moves.
+        MoveList all_moves;
+        squares[square]->get_moves(*this, to_cell(square), all_moves);
+        for (Move move : all_moves)
+        {
+            if (contains(move.to) && (targets & square_bit(to_square(move.to))))
+            {
+                moves.push_back(move);
+            }
+        }
+    }
+    for (Move move : moves)
+    {
+        if (piece_type_masks[KING] & square_bit(to_square(move.to)))
+        {
+            moves.has_king_capture = true;
+            moves.king_capture_move = move;
+            break;
+        }
+    }
+    return moves;
+}
+
+bool Board::is_legal(Move move) const
+{
+    if (!contains(move.from) || !contains(move.to))
+    {
+        return false;
+    }
+    int from = to_square(move.from);
+    if (!(team_masks[current_teams_turn] & square_bit(from)))
+    {
+        return false;
+    }
+    if (code_type(codes[from]) != CUSTOM_PIECE)
+    {
+        return (move_targets(from) & square_bit(to_square(move.to))) != 0;
+    }
+    MoveList moves;
+    squares[from]->get_moves(*this, move.from, moves);
+    return find(moves.begin(), moves.end(), move) != moves.end();
+}
+
 // This function represents how most classical chess ALL_CHESS_PIECES would move.
 // This also allows us to add support for more complex "moves", like a pawn
 // getting to the end of the board and turning into a queen or some other type
@@ -158,12 +305,14 @@ vector<Move> Board::get_moves() const
 // add really interesting custom ALL_CHESS_PIECES that are nothing like normal ALL_CHESS_PIECES!
 void Board::make_classical_chess_move(Move move)
 {
-    board[move.to.y][move.to.x] = board[move.from.y][move.from.x];
-    board[move.from.y][move.from.x] = &EMPTY_SPACE;
+    int from = to_square(move.from);
+    set_square(to_square(move.to), *squares[from]);
+    set_square(from, EMPTY_SPACE);
     current_teams_turn = current_teams_turn == WHITE ? BLACK : WHITE;
+    zobrist_hash ^= ZOBRIST_BLACK_TO_MOVE;
 }
 
-void Board::make_move(Move move)
+UndoRecord Board::make_move(Move move)
 {
     if (!contains(move.to) || !contains(move.from))
     {
@@ -171,81 +320,183 @@ void Board::make_move(Move move)
         err_msg << "Board::make_move called with a move that moves to or from a cell that is not on the board: " << move;
         throw out_of_range(err_msg.str());
     }
-    board[move.from.y][move.from.x]->make_move(*this, move);
+    UndoRecord undo;
+    undo.move = move;
+    undo.moved_piece = squares[to_square(move.from)];
+    undo.captured_piece = squares[to_square(move.to)];
+    undo.previous_turn = current_teams_turn;
+    undo.previous_hash = zobrist_hash;
+    undo_log = &undo;
+    if (code_type(undo.moved_piece->code) != CUSTOM_PIECE)
+    {
+        // All the built in pieces move the classical way.
+        make_classical_chess_move(move);
+        undo_log = nullptr;
+        return undo;
+    }
+    try
+    {
+        undo.moved_piece->make_move(*this, move);
+    }
+    catch (...)
+    {
+        undo_log = nullptr;
+        throw;
+    }
+    undo_log = nullptr;
+    return undo;
 }
 
-bool Board::contains(Cell cell) const
+void Board::unmake_move(const UndoRecord& undo)
 {
-    return cell.x >= 0 && cell.x < 8 && cell.y >= 0 && cell.y < 8;
+    if (code_type(undo.moved_piece->code) != CUSTOM_PIECE)
+    {
+        restore(undo);
+        return;
+    }
+    undo.moved_piece->unmake_move(*this, undo);
 }
 
-Team Board::winner() const
+void Board::restore(const UndoRecord& undo)
 {
-    bool found_white_king = false, found_black_king = false;
-    for (int y = 0; y < rows; ++y)
+    for (int i = undo.num_changes - 1; i >= 0; --i)
     {
-        for (int x = 0; x < cols; ++x)
+        set_square(undo.changed_squares[i], *undo.previous_pieces[i]);
+    }
+    current_teams_turn = undo.previous_turn;
+    zobrist_hash = undo.previous_hash;
+}
+
+void Board::place_piece(Cell cell, const ChessPiece& piece)
+{
+    if (!contains(cell))
+    {
+        stringstream err_msg;
+        err_msg << "Board::place_piece called with a cell that is not on the board: " << cell;
+        throw out_of_range(err_msg.str());
+    }
+    set_square(to_square(cell), piece);
+}
+
+PackedMove Board::pack_move(Move move) const
+{
+    const ChessPiece& mover = *squares[to_square(move.from)];
+    Bitboard to = square_bit(to_square(move.to));
+    Team enemy = mover.team == WHITE ? BLACK : mover.team == BLACK ? WHITE : NONE;
+    uint16_t flags = 0;
+    if (enemy != NONE && (team_masks[enemy] & to))
+    {
+        flags |= PackedMove::CAPTURE;
+        if (piece_type_masks[KING] & to)
         {
-            if (board[y][x] == &WHITE_KING)
-            {
-                found_white_king = true;
-            }
-            else if (board[y][x] == &BLACK_KING)
-            {
-                found_black_king = true;
-            }
+            flags |= PackedMove::KING_CAPTURE;
         }
     }
-    if (!found_white_king)
+    if (code_type(mover.code) == CUSTOM_PIECE)
+    {
+        flags |= PackedMove::SPECIAL;
+    }
+    return PackedMove(move, flags);
+}
+
+void Board::set_turn(Team team)
+{
+    if (team != current_teams_turn)
+    {
+        current_teams_turn = team;
+        zobrist_hash ^= ZOBRIST_BLACK_TO_MOVE;
+    }
+}
+
+int Board::compute_score() const
+{
+    int score = 0;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        score += piece_square_score(squares[square]->type, squares[square]->team, square);
+    }
+    return score;
+}
+
+uint64_t Board::compute_hash() const
+{
+    uint64_t hash = current_teams_turn == BLACK ? ZOBRIST_BLACK_TO_MOVE : 0;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        hash ^= squares[square]->zobrist_key(square);
+    }
+    return hash;
+}
+
+Team Board::winner() const
+{
+    if (!pieces(KING, WHITE))
     {
         return BLACK;
     }
-    if (!found_black_king)
+    if (!pieces(KING, BLACK))
     {
         return WHITE;
     }
     return NONE;
 }
 
-ostream& operator<<(ostream& os, const Board& board)
+void append_board_text(string& out, int rows, int cols, const ChessPiece* const* cells)
 {
-    os << "   ";
-    for (int i = 0; i < board.cols; ++i)
+    out += "   ";
+    for (int i = 0; i < cols; ++i)
     {
-        os << static_cast<char>(i + 'a');
+        out += static_cast<char>(i + 'a');
     }
-    os << endl;
-    for (int y = board.rows - 1; y >= 0; --y)
+    out += '\n';
+    for (int y = rows - 1; y >= 0; --y)
     {
         if (y < 10 - 1)
         {
-            os << ' ';
+            out += ' ';
         }
-        os << (y + 1) << ' ';
-        for (int x = 0; x < board.cols; ++x)
+        out += std::to_string(y + 1);
+        out += ' ';
+        for (int x = 0; x < cols; ++x)
         {
-            os << board[Cell(x, y)];
+            char bytes[4];
+            out.append(bytes, static_cast<size_t>(cells[y * cols + x]->utf8_codepoint.encode(bytes)));
         }
-        os << ' ' << (y + 1) << endl;
+        out += ' ';
+        out += std::to_string(y + 1);
+        out += '\n';
     }
-    os << "   ";
-    for (int i = 0; i < board.cols; ++i)
+    out += "   ";
+    for (int i = 0; i < cols; ++i)
     {
-        os << static_cast<char>(i + 'a');
+        out += static_cast<char>(i + 'a');
     }
-    os << endl;
-    return os;
+    out += '\n';
 }
 
-istream& operator>>(istream& is, Board& board)
+void append_board(string& out, const Board& board)
 {
+    append_board_text(out, board.rows, board.cols, board.squares);
+}
+
+ostream& operator<<(ostream& os, const Board& board)
+{
+    // Builds the whole board first, so it takes one write (and no flushes).
+    string text;
+    append_board(text, board);
+    return os.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+BoardText read_board_text(istream& is)
+{
+    BoardText text;
     string begline;
     getline(is, begline);
     if (begline.find("   ab") == string::npos)
     {
         throw runtime_error("First row of chess board input does not match expected headers!");
     }
-    board.cols = begline.size() - 3;  // 3 spaces at beginning 
+    text.cols = begline.size() - 3;  // 3 spaces at beginning 
     
     streampos cur = is.tellg();  // save cur pos at beginning of line
     char num_char_tens = is.get();
@@ -257,12 +508,15 @@ istream& operator>>(istream& is, Board& board)
         rows_str.pop_back();
     }
     rows_str.push_back(num_char_ones);
-    board.rows = std::stoi(rows_str);
-    board.board.clear();
-    board.board.resize(board.rows, vector<const ChessPiece* >(board.cols));
+    text.rows = std::stoi(rows_str);
+    if (text.rows < 1)
+    {
+        throw runtime_error("Chess board input has no rows!");
+    }
     is.seekg(cur, is.beg);
 
-    for (int y = board.rows - 1; y >= 0; --y)
+    text.cells.resize(static_cast<size_t>(text.rows * text.cols));
+    for (int y = text.rows - 1; y >= 0; --y)
     {
         char beg_buf[3]{};
         is.read(beg_buf, sizeof(beg_buf));
@@ -270,16 +524,48 @@ istream& operator>>(istream& is, Board& board)
         {
             throw runtime_error("Failed to read beginning of chess board row!");
         }
-        for (int x = 0; x < board.cols; ++x)
+        for (int x = 0; x < text.cols; ++x)
         {
             UTF8CodePoint piece;
             is >> piece;
-            board.board[y][x] = ALL_CHESS_PIECES.at(piece);
+            text.cells[static_cast<size_t>(y * text.cols + x)] = ALL_CHESS_PIECES.at(piece);
         }
         string endofline;
         getline(is, endofline);
     }
     string lastline;
     getline(is, lastline);
+    return text;
+}
+
+void Board::load(const BoardText& text)
+{
+    if (text.rows != rows || text.cols != cols)
+    {
+        throw runtime_error("Chess board input is " + std::to_string(text.cols) + "x" + std::to_string(text.rows) +
+                            ", but a Board is 8x8!");
+    }
+    // Only the built in pieces can be read, so the most moves each team could
+    // ever have is known before the game starts, instead of overflowing a
+    // MoveList in the middle of it.
+    Board empty_board;
+    empty_board.clear_board();
+    BitboardGeometry empty_geometry(empty_board);
+    if (most_team_moves(empty_geometry, text, WHITE) > MoveList::CAPACITY ||
+        most_team_moves(empty_geometry, text, BLACK) > MoveList::CAPACITY)
+    {
+        throw runtime_error("Chess board input has too many pieces: they could have more moves than a MoveList holds!");
+    }
+    clear_board();
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        set_square(square, *text.cells[static_cast<size_t>(square)]);
+    }
+    zobrist_hash = compute_hash();
+}
+
+istream& operator>>(istream& is, Board& board)
+{
+    board.load(read_board_text(is));
     return is;
-}
\ No newline at end of file
+}
@@ -1,15 +1,21 @@
 #ifndef _CHESS_BOARD_H_
 #define _CHESS_BOARD_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <map>
+#include <string>
 #include <vector>
 
+#include "bitboard.h"
 #include "utf8_codepoint.h"
 
 using std::istream;
 using std::map;
 using std::ostream;
+using std::string;
 using std::vector;
 
 class ChessPiece;
@@ -23,6 +29,41 @@ enum Team
 
 const char* team_name(Team team);
 
+// The kind of piece, independent of its team. The Board keeps one Bitboard per
+// PieceType. Pieces that are not one of the built in kinds use CUSTOM_PIECE.
+enum PieceType
+{
+    NO_PIECE,
+    KING,
+    QUEEN,
+    BISHOP,
+    KNIGHT,
+    ROOK,
+    PAWN,
+    COWARDLY_DOG,
+    DARK_KNIGHT,
+    CUSTOM_PIECE,
+    NUM_PIECE_TYPES
+};
+
+// A piece's kind and team packed into one byte, which is what the Board
+// keeps on each cell to generate moves: the PieceType in the low 4 bits and
+// the Team above them. See ChessPiece::code.
+typedef uint8_t PieceCode;
+
+constexpr PieceCode make_piece_code(PieceType type, Team team)
+{
+    return static_cast<PieceCode>(team << 4 | type);
+}
+constexpr PieceType code_type(PieceCode code)
+{
+    return static_cast<PieceType>(code & 15);
+}
+constexpr Team code_team(PieceCode code)
+{
+    return static_cast<Team>(code >> 4);
+}
+
 // A place on the board
 struct Cell
 {
@@ -30,7 +71,7 @@ struct Cell
     int y; // rank - 'a' (so we start at 0 instead of 'a')
 
     Cell() = default;
-    Cell(int x, int y) : x(x), y(y) {}
+    constexpr Cell(int x, int y) : x(x), y(y) {}
     bool operator==(Cell other) const;
     bool operator!=(Cell other) const;
 };
@@ -38,6 +79,16 @@ struct Cell
 ostream& operator<<(ostream& os, const Cell& cell);
 istream& operator>>(istream& is, Cell& cell);
 
+// Converts between a Cell and its bit number in a Bitboard.
+inline int to_square(Cell cell)
+{
+    return cell.y * 8 + cell.x;
+}
+inline Cell to_cell(int square)
+{
+    return Cell(square % 8, square / 8);
+}
+
 struct Move
 {
     Cell from, to;
@@ -51,19 +102,228 @@ struct Move
 ostream& operator<<(ostream& os, const Move& move);
 istream& operator>>(istream& is, Move& move);
 
-class Board
+// A Move packed into 16 bits, for keeping lots of moves around (in tables,
+// books and game records) at an eighth of the size:
+// | bits  0-5  | from square
+// | bits  6-11 | to square
+// | bits 12-15 | flags
+// The flags are only set by Board::pack_move, which can see the pieces.
+// The all-zero PackedMove (a1 to a1) is never a real move, so it can stand
+// for "no move".
+struct PackedMove
+{
+    static constexpr uint16_t CAPTURE = 1 << 12;      // takes an enemy piece
+    static constexpr uint16_t KING_CAPTURE = 1 << 13; // takes the enemy king, which wins
+    static constexpr uint16_t SPECIAL = 1 << 14;      // made by a custom piece, which may change any cells
+    static constexpr uint16_t FLAGS = 0xF000;
+
+    uint16_t bits = 0;
+
+    PackedMove() = default;
+    explicit PackedMove(Move move, uint16_t flags = 0)
+        : bits(static_cast<uint16_t>(::to_square(move.from) | ::to_square(move.to) << 6 | flags)) {}
+
+    int from_square() const { return bits & 63; }
+    int to_square() const { return (bits >> 6) & 63; }
+    Move move() const { return Move(to_cell(from_square()), to_cell(to_square())); }
+    uint16_t flags() const { return bits & FLAGS; }
+    bool is_capture() const { return bits & CAPTURE; }
+    bool is_king_capture() const { return bits & KING_CAPTURE; }
+    bool is_special() const { return bits & SPECIAL; }
+    bool empty() const { return bits == 0; }
+
+    // Compares the flags too. Compare move()s to ignore them.
+    bool operator==(PackedMove other) const { return bits == other.bits; }
+    bool operator!=(PackedMove other) const { return bits != other.bits; }
+};
+
+static_assert(sizeof(PackedMove) == 2, "PackedMove should be 16 bits");
+
+// The same text as a Move ("e2e4"), without the flags.
+ostream& operator<<(ostream& os, const PackedMove& move);
+istream& operator>>(istream& is, PackedMove& move);
+
+// Throws out_of_range, for a BasicMoveList with no room left.
+[[noreturn]] void throw_move_list_full();
+
+// A list of at most Capacity moves that lives on the stack instead of the
+// heap, so generating moves every turn doesn't allocate memory. Each board
+// size has its own Capacity (see MoveList and BasicBoard::MoveList).
+template <int Capacity>
+class BasicMoveList
+{
+public:
+    static constexpr int CAPACITY = Capacity;
+
+    BasicMoveList() = default;
+    BasicMoveList(std::initializer_list<Move> moves)
+    {
+        for (Move move : moves)
+        {
+            push_back(move);
+        }
+    }
+
+    void push_back(Move move)
+    {
+        if (count == CAPACITY)
+        {
+            throw_move_list_full();
+        }
+        moves[count++] = move;
+    }
+    void emplace_back(Cell from, Cell to) { push_back(Move(from, to)); }
+    void clear()
+    {
+        count = 0;
+        has_king_capture = false;
+    }
+    size_t size() const { return static_cast<size_t>(count); }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](size_t i) { return moves[i]; }
+    const Move& operator[](size_t i) const { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+    // Whether one of the moves captures the other team's king, which wins the
+    // game. Board::get_moves (and get_captures) works this out as it checks
+    // the moves, so a search can stop right away without making any of them.
+    bool captures_king() const { return has_king_capture; }
+    // One of the moves that captures the king, if captures_king().
+    Move king_capture() const { return king_capture_move; }
+
+private:
+    template <int Rows, int Cols>
+    friend class BasicBoard;
+
+    int count = 0;
+    bool has_king_capture = false;
+    Move king_capture_move{};
+    Move moves[static_cast<size_t>(Capacity)];
+};
+
+// The moves of a Board.
+//
+// A built in piece never has more moves than it has from its best square on
+// an empty board (a queen 27, a rook 14, a bishop 13, a CowardlyDog 9,
+// knights and kings 8 and pawns 3), except a DarkKnight, whose grapple gun
+// could take it to any of the other 63 cells (see most_moves in
+// piece_moves.h). Board::load rejects positions where those add up to more
+// than 256 for either team. The built in pieces never add material, and a
+// capture only takes a piece (and its share of the sum) away, so their games
+// can't fill a MoveList (the starting pieces have at most 129 moves). Custom
+// pieces list their own moves, so push_back still throws if one of them
+// does. The bigger BasicBoards bound their moves the same way.
+typedef BasicMoveList<256> MoveList;
+
+// Everything Board::unmake_move needs to take back a move made with
+// Board::make_move. While a piece's make_move runs, the Board writes down every
+// cell it changes (and what used to be there), so custom pieces that change
+// several cells get undone correctly without any extra work.
+struct UndoRecord
 {
-    int rows = 8;
-    int cols = 8;
-    vector<vector<const ChessPiece* > > board;
-    Team current_teams_turn;
+    static constexpr int MAX_CHANGES = 8;
+
+    Move move{};
+    const ChessPiece* moved_piece = nullptr;
+    const ChessPiece* captured_piece = nullptr;
+    Team previous_turn = NONE;
+    uint64_t previous_hash = 0;
+    // The changed cells and their previous pieces, in the order they changed.
+    int num_changes = 0;
+    int changed_squares[MAX_CHANGES];
+    const ChessPiece* previous_pieces[MAX_CHANGES];
+    // Free for a custom piece to remember anything else its make_move changed,
+    // for use by its unmake_move.
+    uint64_t piece_data = 0;
+};
+
+// XORed into a board's Zobrist hash when it is black's turn.
+const uint64_t ZOBRIST_BLACK_TO_MOVE = 0xF3A9C6D1B2E48705ull;
+
+// A board with Rows x Cols cells. BasicBoard<8, 8>, which is called Board,
+// is the one the game, the players and the searches use: it keeps a Bitboard
+// for each kind of piece and its size is fixed at compile time, so its loops
+// know exactly how many cells there are. Boards of other sizes, for big
+// variants, are in basic_board.h.
+template <int Rows, int Cols>
+class BasicBoard;
+
+// A board as text, as operator<< prints it: its size and the piece on each
+// cell, indexed by y * cols + x.
+struct BoardText
+{
+    int rows = 0;
+    int cols = 0;
+    vector<const ChessPiece*> cells{};
+};
+
+// Reads a board of any size, as operator<< prints it. Throws runtime_error if
+// the text isn't a board.
+BoardText read_board_text(istream& is);
+
+// Adds the text of a board with rows x cols cells to the end of out. cells
+// holds the piece on each cell, indexed by y * cols + x.
+void append_board_text(string& out, int rows, int cols, const ChessPiece* const* cells);
+
+template <>
+class BasicBoard<8, 8>
+{
+public:
+    typedef ::MoveList MoveList;
+
+private:
+    // The piece on each cell, indexed by to_square(cell).
+    const ChessPiece* squares[BOARD_SQUARES];
+    // The code of the piece on each cell.
+    PieceCode codes[BOARD_SQUARES];
+    // Where the pieces of each type and team are. The masks for NO_PIECE and
+    // NONE hold the empty cells.
+    Bitboard piece_type_masks[NUM_PIECE_TYPES];
+    Bitboard team_masks[3];
+    Bitboard occupied = 0;
+    Team current_teams_turn = WHITE;
+    // Zobrist hash of the pieces and whose turn it is, kept up to date by
+    // set_square and make_classical_chess_move.
+    uint64_t zobrist_hash = 0;
+    // The sum of piece_square_score for every piece (see evaluation.h), also
+    // kept up to date by set_square.
+    int piece_square_total = 0;
+    // Where set_square writes down changes while make_move runs, or nullptr.
+    UndoRecord* undo_log = nullptr;
+
+    // Empties every cell on the board.
+    void clear_board();
+    // Puts piece on square and updates the bitboards.
+    void set_square(int square, const ChessPiece& piece);
+    // The cells the built in piece on square can move to, or 0 for a custom
+    // piece (only its own get_moves knows).
+    Bitboard move_targets(int square) const;
+    // The moves of the current team that land on one of the targets.
+    MoveList get_moves_onto(Bitboard targets) const;
 
 public:
-    Board();
+    static constexpr int rows = 8;
+    static constexpr int cols = 8;
+
+    BasicBoard();
     const ChessPiece& operator[](Cell cell) const;
     // Reset all the pieces on the board (as if you're starting a new game).
     void reset_board();
-    vector<Move> get_moves() const;
+    MoveList get_moves() const;
+    // Only the moves from get_moves that capture a piece of the other team,
+    // in the same order. Built in pieces only look at the cells they can
+    // capture on, so this is much cheaper than filtering get_moves.
+    MoveList get_captures() const;
+    // Only the moves that capture the other team's king (usually none).
+    MoveList get_king_captures() const;
+    // Whether move is one of the moves get_moves would return, worked out
+    // from the bitboards without generating the others (except for custom
+    // pieces, which generate their own moves to check).
+    bool is_legal(Move move) const;
     // This function represents how most classical chess pieces would move.
     // This also allows us to add support for more complex "moves", like a pawn
     // getting to the end of the board and turning into a queen or some other type
@@ -72,14 +332,71 @@ public:
     // add really interesting custom pieces that are nothing like normal pieces!
     void make_classical_chess_move(Move move);
     // Makes a move on the board by calling make_move on the piece at move.from.
-    void make_move(Move move);
+    // Returns a record that unmake_move can use to take the move back, so
+    // lookahead players can explore moves without copying the Board.
+    UndoRecord make_move(Move move);
+    // Takes back the most recent move that has not been taken back yet, by
+    // calling unmake_move on the piece that made it.
+    void unmake_move(const UndoRecord& undo);
+    // Puts the changed cells and the turn back the way they were before the
+    // move in undo. This is how most pieces unmake their moves.
+    void restore(const UndoRecord& undo);
+    // Puts piece on cell. Custom pieces can use this from make_move to change
+    // cells other than move.from and move.to.
+    void place_piece(Cell cell, const ChessPiece& piece);
     // Returns true if cell is on the board
-    bool contains(Cell cell) const;
-    // Returns the winner or NONE if there is no winner (yet).
+    static constexpr bool contains(Cell cell)
+    {
+        return cell.x >= 0 && cell.x < cols && cell.y >= 0 && cell.y < rows;
+    }
+    // Replaces every piece with the ones in text, which must be 8x8 and have
+    // few enough pieces that their moves always fit in a MoveList (see
+    // MoveList), or else this throws runtime_error. Doesn't change whose turn
+    // it is.
+    void load(const BoardText& text);
+    // The cells occupied by pieces of the given type and/or team.
+    Bitboard pieces(PieceType type) const { return piece_type_masks[type]; }
+    Bitboard pieces(Team team) const { return team_masks[team]; }
+    Bitboard pieces(PieceType type, Team team) const { return piece_type_masks[type] & team_masks[team]; }
+    // The cells that hold a piece of either team.
+    Bitboard occupancy() const { return occupied; }
+    // move packed with flags that say whether it captures something (or the
+    // king) and whether a custom piece makes it.
+    PackedMove pack_move(Move move) const;
+    // The ChessPiece::code of the piece on square, which is quicker to check
+    // than comparing pieces.
+    PieceCode code(int square) const { return codes[square]; }
+    // Returns the winner or NONE if there is no winner (yet). A team wins once
+    // the other team has no king left. The Board keeps track of where the
+    // kings are, so this takes no time at all.
     Team winner() const;
+    // Whose turn it is.
+    Team turn() const { return current_teams_turn; }
+    // Changes whose turn it is, e.g. after reading a board with operator>>.
+    void set_turn(Team team);
+    // A 64 bit Zobrist hash of the position (the pieces and whose turn it is).
+    // Equal positions have equal hashes, and it costs nothing to look up.
+    uint64_t hash() const { return zobrist_hash; }
+    // Works out the Zobrist hash from scratch.
+    uint64_t compute_hash() const;
+    // The material and piece-square score (see evaluation.h) from white's
+    // point of view. It changes with every piece that is placed or removed,
+    // so it is always up to date and costs nothing to look up.
+    int score() const { return piece_square_total; }
+    // Works out score() from scratch.
+    int compute_score() const;
 
-    friend ostream& operator<<(ostream& os, const Board& board);
-    friend istream& operator>>(istream& is, Board& board);
+    friend void append_board(string& out, const BasicBoard& board);
 };
 
+typedef BasicBoard<8, 8> Board;
+
+// Adds the text operator<< prints for board to the end of out.
+void append_board(string& out, const Board& board);
+
+ostream& operator<<(ostream& os, const Board& board);
+// Reads an 8x8 board. Boards of other sizes throw runtime_error; read those
+// with read_board_text and visit_board (in basic_board.h).
+istream& operator>>(istream& is, Board& board);
+
 #endif // _CHESS_BOARD_H_
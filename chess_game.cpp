@@ -0,0 +1,192 @@
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include "chess_board.h"
+#include "chess_game.h"
+#include "chess_pieces.h"
+#include "chess_player.h"
+
+using std::endl;
+using std::ostream;
+using std::string;
+
+bool play_chess_one_turn(Board& board, Player& player, ostream& os)
+{
+    os << board << endl;
+    os << player.name() << "'s turn." << endl;
+    MoveList moves = board.get_moves();
+    if (moves.empty())
+    {
+        os << player.name() << " has no moves.\n\n";
+        return false;
+    }
+    Move move;
+    while (true)
+    {
+        move = player.get_move(board, moves);
+        if (board.is_legal(move))
+        {
+            break;
+        }
+    }
+    os
+        << player.name() << " chose to move " << board[move.from]
+        << " from " << move.from << " to " << move.to << " ("
+        << board[move.to] << ")\n\n";
+    board.make_move(move);
+    return true;
+}
+
+Team play_one_chess_game(Player& white_player, Player& black_player, ostream& os, int max_turns)
+{
+    Board board;
+    for (int turn = 0; max_turns == 0 || turn < max_turns; ++turn)
+    {
+        if (!play_chess_one_turn(board, board.turn() == WHITE ? white_player : black_player, os) ||
+            board.winner() != NONE)
+        {
+            break;
+        }
+    }
+    Team winner = board.winner();
+    if (winner == NONE)
+    {
+        os << "Draw!\n";
+    }
+    else
+    {
+        os << team_name(winner) << " won!\n";
+    }
+    return winner;
+}
+
+// Adds a cell like "b1" to the end of out.
+static void append_cell(string& out, Cell cell)
+{
+    out += static_cast<char>(cell.x + 'a');
+    out += std::to_string(cell.y + 1);
+}
+
+static void append_piece(string& out, const ChessPiece& piece)
+{
+    char bytes[4];
+    out.append(bytes, static_cast<size_t>(piece.utf8_codepoint.encode(bytes)));
+}
+
+GameLog::GameLog(ostream& os, LogLevel level, size_t buffer_size, std::mutex* os_lock)
+    : os(os), log_level(level), buffer_size(buffer_size), os_lock(os_lock), buffer()
+{
+    buffer.reserve(buffer_size);
+}
+
+GameLog::~GameLog()
+{
+    flush();
+}
+
+void GameLog::log_move(const Board& board, const Player& player, Move move)
+{
+    if (log_level == LOG_MOVES)
+    {
+        append_cell(buffer, move.from);
+        append_cell(buffer, move.to);
+        buffer += ' ';
+    }
+    else if (log_level == LOG_BOARDS)
+    {
+        append_board(buffer, board);
+        buffer += '\n';
+        buffer += player.name();
+        buffer += "'s turn.\n";
+        buffer += player.name();
+        buffer += " chose to move ";
+        append_piece(buffer, board[move.from]);
+        buffer += " from ";
+        append_cell(buffer, move.from);
+        buffer += " to ";
+        append_cell(buffer, move.to);
+        buffer += " (";
+        append_piece(buffer, board[move.to]);
+        buffer += ")\n\n";
+    }
+}
+
+void GameLog::log_no_moves(const Player& player)
+{
+    if (log_level == LOG_BOARDS)
+    {
+        buffer += player.name();
+        buffer += " has no moves.\n\n";
+    }
+}
+
+void GameLog::log_game_over(Team winner, int turns)
+{
+    if (log_level == LOG_NONE)
+    {
+        return;
+    }
+    if (log_level == LOG_MOVES)
+    {
+        buffer += winner == WHITE ? "1-0" : winner == BLACK ? "0-1" : "1/2-1/2";
+    }
+    else
+    {
+        buffer += winner == NONE ? string("Draw") : string(team_name(winner)) + " won";
+        buffer += " after ";
+        buffer += std::to_string(turns);
+        buffer += " turns.";
+    }
+    buffer += '\n';
+    if (buffer.size() >= buffer_size)
+    {
+        flush();
+    }
+}
+
+void GameLog::flush()
+{
+    if (buffer.empty())
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> guard;
+    if (os_lock)
+    {
+        guard = std::unique_lock<std::mutex>(*os_lock);
+    }
+    os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    os.flush();
+    buffer.clear();
+}
+
+Team play_one_chess_game(Player& white_player, Player& black_player, GameLog& log, int max_turns)
+{
+    Board board;
+    int turns = 0;
+    while (board.winner() == NONE && (max_turns == 0 || turns < max_turns))
+    {
+        Player& player = board.turn() == WHITE ? white_player : black_player;
+        MoveList moves = board.get_moves();
+        if (moves.empty())
+        {
+            log.log_no_moves(player);
+            break;
+        }
+        Move move;
+        do
+        {
+            move = player.get_move(board, moves);
+        } while (!board.is_legal(move));
+        if (log.level() >= LOG_MOVES)
+        {
+            log.log_move(board, player, move);
+        }
+        board.make_move(move);
+        ++turns;
+    }
+    Team winner = board.winner();
+    log.log_game_over(winner, turns);
+    return winner;
+}
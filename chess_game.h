@@ -0,0 +1,73 @@
+#ifndef _CHESS_GAME_H_
+#define _CHESS_GAME_H_
+
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+#include "chess_board.h"
+#include "chess_player.h"
+
+using std::ostream;
+using std::string;
+
+// How much a GameLog writes about each game. Each level includes the ones
+// before it.
+enum LogLevel
+{
+    LOG_NONE,
+    LOG_RESULT, // one line per game with the winner and number of turns
+    LOG_MOVES,  // one line per game with every move and the result
+    LOG_BOARDS  // the board before every turn, like the interactive game
+};
+
+// Collects what happens in games into a large buffer and writes it to an
+// ostream in big chunks, between games, without flushing after every line.
+// With LOG_NONE nothing is ever formatted.
+//
+// A LOG_MOVES line looks like "b1c3 g8f6 ... e4e8 1-0", with 1-0 for a white
+// win, 0-1 for a black win and 1/2-1/2 for a draw.
+class GameLog
+{
+public:
+    // If os_lock isn't nullptr it's locked while writing to os, so GameLogs
+    // on different threads can share os.
+    GameLog(ostream& os, LogLevel level, size_t buffer_size = 1 << 20, std::mutex* os_lock = nullptr);
+    ~GameLog();
+    GameLog(const GameLog&) = delete;
+    GameLog& operator=(const GameLog&) = delete;
+
+    LogLevel level() const { return log_level; }
+
+    // Called before player makes move on board.
+    void log_move(const Board& board, const Player& player, Move move);
+    // Called when the team whose turn it is has no moves.
+    void log_no_moves(const Player& player);
+    // Called at the end of every game. Writes the buffer to os if it's full.
+    void log_game_over(Team winner, int turns);
+    // Writes everything in the buffer to os and flushes os.
+    void flush();
+
+private:
+    ostream& os;
+    LogLevel log_level;
+    size_t buffer_size;
+    std::mutex* os_lock;
+    string buffer;
+};
+
+// Prints the board, asks player for a move and makes it. Returns false if
+// there were no moves to make.
+bool play_chess_one_turn(Board& board, Player& player, ostream& os);
+
+// Plays a game from the starting position until a king is captured. Returns
+// the winner, or NONE for a draw: when the team whose turn it is has no moves,
+// or after max_turns turns (if max_turns isn't 0).
+Team play_one_chess_game(Player& white_player, Player& black_player, ostream& os, int max_turns = 0);
+
+// The same game, but for playing lots of games quickly: it only writes what
+// log asks for, through log's buffer.
+Team play_one_chess_game(Player& white_player, Player& black_player, GameLog& log, int max_turns = 0);
+
+#endif // _CHESS_GAME_H_
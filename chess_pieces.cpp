@@ -1,5 +1,35 @@
 #include "utf8_codepoint.h"
 #include "chess_pieces.h"
+#include "piece_moves.h"
+
+// SplitMix64: turns a counter into a well mixed 64 bit number. We use it to
+// make Zobrist keys that are the same every time the program runs.
+static uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+ChessPiece::ChessPiece(UTF8CodePoint cp, Team team, PieceType type, bool built_in)
+    : utf8_codepoint(cp), team(team), type(type), code(make_piece_code(built_in ? type : CUSTOM_PIECE, team))
+{
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        zobrist_keys[square] = zobrist_key(square, BOARD_SQUARES);
+    }
+}
+
+uint64_t ChessPiece::zobrist_key(int cell, int num_cells) const
+{
+    if (team == NONE)
+    {
+        return 0;
+    }
+    return splitmix64(static_cast<uint64_t>(char32_t(utf8_codepoint)) * static_cast<uint64_t>(num_cells) +
+                      static_cast<uint64_t>(cell));
+}
 
 bool ChessPiece::is_opposite_team(const ChessPiece& other) const
 {
@@ -20,336 +50,73 @@ ostream& operator<<(ostream& os, const ChessPiece& p)
     return os << p.utf8_codepoint;
 }
 
+void ChessPiece::unmake_move(Board& board, const UndoRecord& undo) const
+{
+    board.restore(undo);
+}
+
 void SimpleChessPiece::make_move(Board& board, Move move) const
 {
     board.make_classical_chess_move(move);
 }
 
-void King::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void King::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    for (int x = from.x - 1; x < from.x + 2; ++x)
-    {
-        for (int y = from.y - 1; y < from.y + 2; ++y)
-        {
-            Cell to(x, y);
-            if (from != to && board.contains(to) && (board[to] == EMPTY_SPACE || is_opposite_team(board[to])))
-            {
-                moves.emplace_back(from, to);
-            }
-        }
-    }
+    add_moves(to_square(from), king_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
-void Queen::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void Queen::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    // The 8 directions a queen can go...
-    Cell directions[] = {
-        {-1, 1},
-        {0, 1},
-        {1, 1},
-        {-1, 0},
-        {1, 0},
-        {-1, -1},
-        {0, -1},
-        {1, -1},
-    };
-    for (Cell direction : directions)
-    {
-        for (int steps = 1;; ++steps)
-        {
-            Cell to(from.x + steps * direction.x, from.y + steps * direction.y);
-            if (!board.contains(to))
-            {
-                break;
-            }
-            const ChessPiece& piece = board[to];
-            if (piece == EMPTY_SPACE)
-            {
-                moves.emplace_back(from, to);
-            }
-            else if (is_opposite_team(piece))
-            {
-                moves.emplace_back(from, to);
-                break;
-            }
-            else
-            { // if (team == piece.team)
-                break;
-            }
-        }
-    }
+    add_moves(to_square(from), queen_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
-void Bishop::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void Bishop::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    // The 4 directions a bishop can go...
-    Cell directions[] = {
-        {-1, 1},
-        {1, 1},
-        {-1, -1},
-        {1, -1},
-    };
-    for (Cell direction : directions)
-    {
-        for (int steps = 1;; ++steps)
-        {
-            Cell to(from.x + steps * direction.x, from.y + steps * direction.y);
-            if (!board.contains(to))
-            {
-                break;
-            }
-            const ChessPiece& piece = board[to];
-            if (piece == EMPTY_SPACE)
-            {
-                moves.emplace_back(from, to);
-            }
-            else if (is_opposite_team(piece))
-            {
-                moves.emplace_back(from, to);
-                break;
-            }
-            else
-            { // if (team == piece.team)
-                break;
-            }
-        }
-    }
+    add_moves(to_square(from), bishop_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
-void Knight::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void Knight::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    Cell jumps[] = {
-        {-1, 2},
-        {1, 2},
-        {-2, 1},
-        {2, 1},
-        {-2, -1},
-        {2, -1},
-        {-1, -2},
-        {1, -2},
-    };
-    for (Cell jump : jumps)
-    {
-        Cell to(from.x + jump.x, from.y + jump.y);
-        if (board.contains(to))
-        {
-            const ChessPiece& piece = board[to];
-            if (piece == EMPTY_SPACE || is_opposite_team(piece))
-            {
-                moves.emplace_back(from, to);
-            }
-        }
-    }
+    add_moves(to_square(from), knight_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
-void Rook::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void Rook::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    // The 4 directions a rook can go...
-    Cell directions[] = {
-        {0, 1},
-        {-1, 0},
-        {1, 0},
-        {0, -1},
-    };
-    for (Cell direction : directions)
-    {
-        for (int steps = 1;; ++steps)
-        {
-            Cell to(from.x + steps * direction.x, from.y + steps * direction.y);
-            if (!board.contains(to))
-            {
-                break;
-            }
-            const ChessPiece& piece = board[to];
-            if (piece == EMPTY_SPACE)
-            {
-                moves.emplace_back(from, to);
-            }
-            else if (is_opposite_team(piece))
-            {
-                moves.emplace_back(from, to);
-                break;
-            }
-            else
-            { // if (team == piece.team)
-                break;
-            }
-        }
-    }
+    add_moves(to_square(from), rook_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
-void Pawn::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void Pawn::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    Cell to = Cell(from.x, from.y + y_move_steps);
-    if (board.contains(to) && board[to] == EMPTY_SPACE)
-    {
-        moves.emplace_back(from, to);
-    }
-
-    to = Cell(from.x - 1, from.y + y_move_steps);
-    if (board.contains(to) && is_opposite_team(board[to]))
-    {
-        moves.emplace_back(from, to);
-    }
-
-    to = Cell(from.x + 1, from.y + y_move_steps);
-    if (board.contains(to) && is_opposite_team(board[to]))
-    {
-        moves.emplace_back(from, to);
-    }
+    add_moves(to_square(from), pawn_targets(BitboardGeometry(board), to_square(from), team, y_move_steps), moves);
 }
 
-void CowardlyDog::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void CowardlyDog::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    // moves like a pawn, but can also flee backwards
-    Cell to = Cell(from.x, from.y + y_move_steps);
-    if (board.contains(to) && board[to] == EMPTY_SPACE)
-    {
-        moves.emplace_back(from, to);
-    }
-
-    to = Cell(from.x - 1, from.y + y_move_steps);
-    if (board.contains(to) && is_opposite_team(board[to]))
-    {
-        moves.emplace_back(from, to);
-    }
-
-    to = Cell(from.x + 1, from.y + y_move_steps);
-    if (board.contains(to) && is_opposite_team(board[to]))
-    {
-        moves.emplace_back(from, to);
-    }
-
-    for (int steps = 1;; ++steps)
-    {
-        Cell to_back(from.x, from.y - steps * y_move_steps);
-        if (!board.contains(to_back))
-        {
-            break;
-        }
-        const ChessPiece& piece = board[to_back];
-        if (piece == EMPTY_SPACE)
-        {
-            moves.emplace_back(from, to_back);
-        }
-        else
-        { // if (piece == piece from either team)
-            continue;  // mah boi can hop over pieces to run away
-        }
-    }
+    add_moves(to_square(from), cowardly_dog_targets(BitboardGeometry(board), to_square(from), team, y_move_steps), moves);
 }
 
-void DarkKnight::get_moves(const Board& board, Cell from, vector<Move>& moves) const
+void DarkKnight::get_moves(const Board& board, Cell from, MoveList& moves) const
 {
-    /* Gotham's greatest hero can move in all 8 directions just like a queen, although only up to 4 tiles.
-       
-       The Dark Knight can also move like a knight would. BECAUSE HES BATMAN!!!
-       
-       Finally, if a rook (of either team) is within his queen moveset direction with unlimited range,
-       he is able to land in any tile adjacent to that rook, 
-       via his grapple gun, even if a piece is blocking the path to the rook. BECAUSE HE'S BATTTMAAAAANN!!!!
-    */
-    Cell directions[] = {
-        {-1, 1},
-        {0, 1},
-        {1, 1},
-        {-1, 0},
-        {1, 0},
-        {-1, -1},
-        {0, -1},
-        {1, -1},
-    };
-    for (Cell direction : directions)
-    {
-        bool impeded = false;
-        for (int steps = 1;; ++steps)
-        {
-            Cell to(from.x + steps * direction.x, from.y + steps * direction.y);
-            if (!board.contains(to))
-            {
-                break;
-            }
-            const ChessPiece& piece = board[to];
-            if (piece == WHITE_ROOK || piece == BLACK_ROOK)
-            {
-                for (Cell direction : directions)
-                {
-                    Cell grapple_to(to.x + direction.x, to.y + direction.y);
-                    if (!board.contains(grapple_to))
-                    {
-                        continue;
-                    }
-                    const ChessPiece& piece_adj_rook = board[grapple_to];
-                    if (piece_adj_rook == EMPTY_SPACE || is_opposite_team(piece_adj_rook))
-                    {
-                        moves.emplace_back(from, grapple_to);
-                    }
-                }
-            }
-            if (piece == EMPTY_SPACE && !impeded)
-            {
-                if (steps <= 4)
-                {
-                    moves.emplace_back(from, to);
-                }
-            }
-            else if (is_opposite_team(piece) && !impeded)
-            {
-                if (steps <= 4)
-                {
-                    moves.emplace_back(from, to);
-                }
-                impeded = true;
-            }
-            else if (team == piece.team && !impeded)
-            {
-                impeded = true;
-            }
-        }
-    }
-
-    // normal knight moveset
-    Cell jumps[] = {
-        {-1, 2},
-        {1, 2},
-        {-2, 1},
-        {2, 1},
-        {-2, -1},
-        {2, -1},
-        {-1, -2},
-        {1, -2},
-    };
-    for (Cell jump : jumps)
-    {
-        Cell to(from.x + jump.x, from.y + jump.y);
-        if (board.contains(to))
-        {
-            const ChessPiece& piece = board[to];
-            if (piece == EMPTY_SPACE || is_opposite_team(piece))
-            {
-                moves.emplace_back(from, to);
-            }
-        }
-    }
+    add_moves(to_square(from), dark_knight_targets(BitboardGeometry(board), to_square(from), team), moves);
 }
 
 const EmptySpace EMPTY_SPACE;
-const King WHITE_KING(U'♔', WHITE);
-const King BLACK_KING(U'♚', BLACK);
-const Queen WHITE_QUEEN(U'♕', WHITE);
-const Queen BLACK_QUEEN(U'♛', BLACK);
-const Bishop WHITE_BISHOP(U'♗', WHITE);
-const Bishop BLACK_BISHOP(U'♝', BLACK);
-const Knight WHITE_KNIGHT(U'♘', WHITE);
-const Knight BLACK_KNIGHT(U'♞', BLACK);
-const Rook WHITE_ROOK(U'♖', WHITE);
-const Rook BLACK_ROOK(U'♜', BLACK);
-const Pawn WHITE_PAWN(U'♙', WHITE, 1);
-const Pawn BLACK_PAWN(U'♟', BLACK, -1);
-const CowardlyDog WHITE_COURAGE(U'♢', WHITE, 1);
-const CowardlyDog BLACK_COURAGE(U'♦', BLACK, -1);
-const DarkKnight WHITE_BATMAN(U'☺', WHITE);
-const DarkKnight BLACK_BATMAN(U'☻', BLACK);
+const King WHITE_KING(U'♔', WHITE, true);
+const King BLACK_KING(U'♚', BLACK, true);
+const Queen WHITE_QUEEN(U'♕', WHITE, true);
+const Queen BLACK_QUEEN(U'♛', BLACK, true);
+const Bishop WHITE_BISHOP(U'♗', WHITE, true);
+const Bishop BLACK_BISHOP(U'♝', BLACK, true);
+const Knight WHITE_KNIGHT(U'♘', WHITE, true);
+const Knight BLACK_KNIGHT(U'♞', BLACK, true);
+const Rook WHITE_ROOK(U'♖', WHITE, true);
+const Rook BLACK_ROOK(U'♜', BLACK, true);
+const Pawn WHITE_PAWN(U'♙', WHITE, 1, true);
+const Pawn BLACK_PAWN(U'♟', BLACK, -1, true);
+const CowardlyDog WHITE_COURAGE(U'♢', WHITE, 1, true);
+const CowardlyDog BLACK_COURAGE(U'♦', BLACK, -1, true);
+const DarkKnight WHITE_BATMAN(U'☺', WHITE, true);
+const DarkKnight BLACK_BATMAN(U'☻', BLACK, true);
 
 const map<UTF8CodePoint, const ChessPiece *> ALL_CHESS_PIECES = {
     {EMPTY_SPACE.utf8_codepoint, &EMPTY_SPACE},
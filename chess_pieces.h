@@ -1,10 +1,12 @@
 #ifndef _CHESS_PIECES_H_
 #define _CHESS_PIECES_H_
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <vector>
 
+#include "attack_tables.h"
 #include "utf8_codepoint.h"
 #include "chess_board.h"
 
@@ -18,13 +20,32 @@ class ChessPiece
 public:
     const UTF8CodePoint utf8_codepoint;
     const Team team;
+    const PieceType type;
+    // What the Board keeps for this piece on each of its cells. It is only
+    // one of the built in kinds for the pieces in ALL_CHESS_PIECES (which
+    // pass built_in), so that the Board can move them without calling their
+    // virtual functions. Every other piece is a CUSTOM_PIECE here, whatever
+    // its type, even if it's a subclass of a built in piece.
+    const PieceCode code;
 
-    ChessPiece(UTF8CodePoint cp, Team team) : utf8_codepoint(cp), team(team) {}
+    ChessPiece(UTF8CodePoint cp, Team team, PieceType type = CUSTOM_PIECE, bool built_in = false);
 
     virtual ~ChessPiece() {}
 
-    virtual void get_moves(const Board& board, Cell from, vector<Move>& moves) const = 0;
+    // The random number this piece XORs into a Board's Zobrist hash when it
+    // stands on square. Keys come from the piece's code point, so any piece in
+    // ALL_CHESS_PIECES (or a custom piece) gets its own set. Empty cells are 0.
+    uint64_t zobrist_key(int square) const { return zobrist_keys[square]; }
+    // The key for cell on a board with num_cells cells, worked out each time
+    // (zobrist_key(square) looks this up for a Board's BOARD_SQUARES).
+    uint64_t zobrist_key(int cell, int num_cells) const;
+
+    virtual void get_moves(const Board& board, Cell from, MoveList& moves) const = 0;
     virtual void make_move(Board& board, Move move) const = 0;
+    // Takes back a move this piece made. The default restores every cell the
+    // move changed through the Board. Pieces that keep track of anything else
+    // can store it in undo.piece_data from make_move and override this.
+    virtual void unmake_move(Board& board, const UndoRecord& undo) const;
 
     bool is_opposite_team(const ChessPiece& other) const;
 
@@ -32,6 +53,9 @@ public:
     bool operator!=(const ChessPiece& other) const;
 
     friend ostream& operator<<(ostream& os, const ChessPiece& p);
+
+private:
+    uint64_t zobrist_keys[BOARD_SQUARES];
 };
 
 ostream& operator<<(ostream& os, const ChessPiece& p);
@@ -39,61 +63,70 @@ ostream& operator<<(ostream& os, const ChessPiece& p);
 class EmptySpace : public ChessPiece
 {
 public:
-    EmptySpace() : ChessPiece('.', NONE) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override {}
+    EmptySpace() : ChessPiece('.', NONE, NO_PIECE, true) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override {}
     void make_move(Board& board, Move move) const override {}
 };
 
 class SimpleChessPiece : public ChessPiece
 {
 public:
-    SimpleChessPiece(UTF8CodePoint cp, Team team) : ChessPiece(cp, team) {}
+    SimpleChessPiece(UTF8CodePoint cp, Team team, PieceType type = CUSTOM_PIECE, bool built_in = false)
+        : ChessPiece(cp, team, type, built_in) {}
     void make_move(Board& board, Move move) const;
 };
 
 class King : public SimpleChessPiece
 {
 public:
-    King(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    King(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, KING, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class Queen : public SimpleChessPiece
 {
 public:
-    Queen(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    Queen(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, QUEEN, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class Bishop : public SimpleChessPiece
 {
 public:
-    Bishop(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    Bishop(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, BISHOP, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class Knight : public SimpleChessPiece
 {
 public:
-    Knight(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    Knight(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, KNIGHT, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class Rook : public SimpleChessPiece
 {
 public:
-    Rook(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    Rook(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, ROOK, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
+// Which way the built in pawns and dogs of team move: white up the board
+// and black down it.
+inline int forward_steps(Team team)
+{
+    return team == WHITE ? 1 : -1;
+}
+
 class Pawn : public SimpleChessPiece
 {
     int y_move_steps;
 
 public:
-    Pawn(UTF8CodePoint cp, Team team, int y_move_steps)
-        : SimpleChessPiece(cp, team), y_move_steps(y_move_steps) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    Pawn(UTF8CodePoint cp, Team team, int y_move_steps, bool built_in = false)
+        : SimpleChessPiece(cp, team, PAWN, built_in && y_move_steps == forward_steps(team)),
+          y_move_steps(y_move_steps) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class CowardlyDog : public SimpleChessPiece
@@ -101,15 +134,17 @@ class CowardlyDog : public SimpleChessPiece
     int y_move_steps;
 
 public:
-    CowardlyDog(UTF8CodePoint cp, Team team, int y_move_steps) : SimpleChessPiece(cp, team), y_move_steps(y_move_steps) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    CowardlyDog(UTF8CodePoint cp, Team team, int y_move_steps, bool built_in = false)
+        : SimpleChessPiece(cp, team, COWARDLY_DOG, built_in && y_move_steps == forward_steps(team)),
+          y_move_steps(y_move_steps) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 class DarkKnight : public SimpleChessPiece
 {
 public:
-    DarkKnight(UTF8CodePoint cp, Team team) : SimpleChessPiece(cp, team) {}
-    void get_moves(const Board& board, Cell from, vector<Move>& moves) const override;
+    DarkKnight(UTF8CodePoint cp, Team team, bool built_in = false) : SimpleChessPiece(cp, team, DARK_KNIGHT, built_in) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override;
 };
 
 // `extern` is used to declare the variables here, without defining them
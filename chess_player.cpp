@@ -1,16 +1,18 @@
-#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <utility>
 
 #include "chess_board.h"
 #include "chess_pieces.h"
 #include "chess_player.h"
+#include "mcts.h"
+#include "opening_book.h"
+#include "search.h"
 
 using std::cin;
 using std::cout;
 using std::endl;
-using std::shuffle;
 using std::vector;
 
 const char* Player::name() const {
@@ -25,19 +27,41 @@ RandomPlayer::RandomPlayer(Team team) : Player(team) {
     std::chrono::system_clock::now().time_since_epoch().count());
 }
 
-Move RandomPlayer::get_move(const Board& board, const vector<Move>& moves) const {
+RandomPlayer::RandomPlayer(Team team, unsigned seed) : Player(team) {
+  random_number_generator.seed(seed);
+}
+
+Move RandomPlayer::get_move(const Board& board, const MoveList& moves) const {
   return moves[random_number_generator() % moves.size()];
 }
 
+// Picks one of the moves it is offered, each with the same chance, without
+// keeping a list of them (reservoir sampling with room for one move): the
+// nth move offered replaces the choice with probability 1/n.
+class MoveSampler {
+  Move chosen{};
+  unsigned offered = 0;
+public:
+  template <class Random>
+  void offer(Move move, Random& random) {
+    ++offered;
+    if (random() % offered == 0) {
+      chosen = move;
+    }
+  }
+  bool empty() const { return offered == 0; }
+  Move choice() const { return chosen; }
+};
+
 HumanPlayer::HumanPlayer(Team team) : Player(team) {}
 
-Move HumanPlayer::get_move(const Board& board, const vector<Move>& moves) const {
+Move HumanPlayer::get_move(const Board& board, const MoveList& moves) const {
   Move move;
   while (true) {
     cout << "What's your move?: ";
     cin >> move;
     cout << endl;
-    if (find(moves.begin(), moves.end(), move) != moves.end()) {
+    if (board.is_legal(move)) {
       break;
     }
     cout << move << " is not a valid move! Please choose one of the following moves: \n";
@@ -56,15 +80,21 @@ CapturePlayer::CapturePlayer(Team team) : Player(team) {
     std::chrono::system_clock::now().time_since_epoch().count());
 }
 
-Move CapturePlayer::get_move(const Board& board, const vector<Move>& moves) const {
-  vector<Move> shuffled_moves = moves;
-  shuffle(shuffled_moves.begin(), shuffled_moves.end(), random_number_generator);
-  for (Move move : shuffled_moves) {
-    if (board[move.from].is_opposite_team(board[move.to])) {
-      return move;
+CapturePlayer::CapturePlayer(Team team, unsigned seed) : Player(team) {
+  random_number_generator.seed(seed);
+}
+
+Move CapturePlayer::get_move(const Board& board, const MoveList& moves) const {
+  MoveSampler captures;
+  for (Move move : moves) {
+    if (board.pack_move(move).is_capture()) {
+      captures.offer(move, random_number_generator);
     }
   }
-  return shuffled_moves[0];
+  if (!captures.empty()) {
+    return captures.choice();
+  }
+  return moves[random_number_generator() % moves.size()];
 }
 
 CheckMateCapturePlayer::CheckMateCapturePlayer(Team team) : Player(team) {
@@ -74,18 +104,60 @@ CheckMateCapturePlayer::CheckMateCapturePlayer(Team team) : Player(team) {
     std::chrono::system_clock::now().time_since_epoch().count());
 }
 
-Move CheckMateCapturePlayer::get_move(const Board& board, const vector<Move>& moves) const {
-  vector<Move> shuffled_moves = moves;
-  shuffle(shuffled_moves.begin(), shuffled_moves.end(), random_number_generator);
-  for (Move move : shuffled_moves) {
-    if (board[move.from].is_opposite_team(board[move.to]) && (board[move.to] == WHITE_KING || board[move.to] == BLACK_KING)) {
-      return move;
+CheckMateCapturePlayer::CheckMateCapturePlayer(Team team, unsigned seed) : Player(team) {
+  random_number_generator.seed(seed);
+}
+
+Move CheckMateCapturePlayer::get_move(const Board& board, const MoveList& moves) const {
+  MoveSampler king_captures, captures;
+  for (Move move : moves) {
+    PackedMove packed = board.pack_move(move);
+    if (packed.is_king_capture()) {
+      king_captures.offer(move, random_number_generator);
+    } else if (packed.is_capture() && king_captures.empty()) {
+      captures.offer(move, random_number_generator);
     }
   }
-  for (Move move : shuffled_moves) {
-    if (board[move.from].is_opposite_team(board[move.to])) {
-      return move;
-    }
+  if (!king_captures.empty()) {
+    return king_captures.choice();
+  }
+  if (!captures.empty()) {
+    return captures.choice();
+  }
+  return moves[random_number_generator() % moves.size()];
+}
+
+SearchPlayer::SearchPlayer(Team team, SearchLimits limits, size_t hash_megabytes, int threads)
+  : Player(team), limits(limits), threads(threads), table(hash_megabytes), last_result(),
+    stop_requested(false) {}
+
+Move SearchPlayer::get_move(const Board& board, const MoveList& moves) const {
+  last_result = parallel_search(table, limits, threads, board, moves, stop_requested);
+  // Only clear the flag once it has been seen, so a stop() that comes in
+  // just before the search starts isn't lost.
+  stop_requested = false;
+  return last_result.best_move;
+}
+
+MctsPlayer::MctsPlayer(Team team, MctsLimits limits, size_t max_nodes, unsigned seed)
+  : Player(team), limits(limits), seed(seed), tree(max_nodes), last_result(), stop_requested(false) {}
+
+Move MctsPlayer::get_move(const Board& board, const MoveList& moves) const {
+  last_result = tree.search(board, moves, limits, stop_requested, seed + 1000 * searches++);
+  stop_requested = false;
+  return last_result.best_move;
+}
+
+BookPlayer::BookPlayer(const OpeningBook& book, std::unique_ptr<Player> player)
+  : Player(player->team), book(book), player(std::move(player)) {}
+
+Move BookPlayer::get_move(const Board& board, const MoveList& moves) const {
+  // A game hardly ever gets back into the book once it has left, so stop
+  // looking.
+  Move move;
+  if (in_book && book.probe(board, move)) {
+    return move;
   }
-  return shuffled_moves[0];
+  in_book = false;
+  return player->get_move(board, moves);
 }
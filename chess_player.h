@@ -1,10 +1,16 @@
 #ifndef _CHESS_PLAYER_H_
 #define _CHESS_PLAYER_H_
 
+#include <atomic>
+#include <memory>
 #include <random>
 #include <vector>
 
 #include "chess_board.h"
+#include "mcts.h"
+#include "opening_book.h"
+#include "search.h"
+#include "transposition_table.h"
 
 using std::vector;
 
@@ -13,8 +19,10 @@ public:
   const Team team;
 
   Player(Team team) : team(team) {}
+  // Players are deleted through Player pointers (e.g. by BookPlayer).
+  virtual ~Player() = default;
 
-  virtual Move get_move(const Board& board, const vector<Move>& moves) const = 0;
+  virtual Move get_move(const Board& board, const MoveList& moves) const = 0;
   virtual const char* name() const;
 };
 
@@ -22,14 +30,16 @@ class RandomPlayer : public Player {
   mutable std::default_random_engine random_number_generator;
 public:
   RandomPlayer(Team team);
+  // Seeds the random number generator with seed, so games can be replayed.
+  RandomPlayer(Team team, unsigned seed);
 
-  Move get_move(const Board& board, const vector<Move>& moves) const override;
+  Move get_move(const Board& board, const MoveList& moves) const override;
 };
 
 class HumanPlayer : public Player {
 public:
   HumanPlayer(Team team);
-  Move get_move(const Board& board, const vector<Move>& moves) const override;
+  Move get_move(const Board& board, const MoveList& moves) const override;
 };
 
 // CapturePlayer plays a random move that captures an opponents piece.
@@ -38,14 +48,74 @@ class CapturePlayer : public Player {
   mutable std::default_random_engine random_number_generator;
 public:
   CapturePlayer(Team team);
-  Move get_move(const Board& board, const vector<Move>& moves) const override;
+  CapturePlayer(Team team, unsigned seed);
+  Move get_move(const Board& board, const MoveList& moves) const override;
 };
 
 class CheckMateCapturePlayer : public Player {
   mutable std::default_random_engine random_number_generator;
 public:
   CheckMateCapturePlayer(Team team);
-  Move get_move(const Board& board, const vector<Move>& moves) const override;
+  CheckMateCapturePlayer(Team team, unsigned seed);
+  Move get_move(const Board& board, const MoveList& moves) const override;
+};
+
+// SearchPlayer looks several moves ahead with an alpha-beta Search and plays
+// the best move it finds within its time or node budget. With more than one
+// thread it uses parallel_search, with all threads sharing one table.
+class SearchPlayer : public Player {
+  SearchLimits limits;
+  int threads;
+  mutable TranspositionTable table;
+  mutable SearchResult last_result;
+  mutable std::atomic<bool> stop_requested;
+public:
+  SearchPlayer(Team team, SearchLimits limits = SearchLimits(), size_t hash_megabytes = 16, int threads = 1);
+  Move get_move(const Board& board, const MoveList& moves) const override;
+  // Makes a get_move that is running on another thread (or the next one, if
+  // none is) return as soon as possible, with the best move it has found so
+  // far.
+  void stop() { stop_requested = true; }
+  // What the last call to get_move found out.
+  const SearchResult& last_search() const { return last_result; }
+};
+
+// MctsPlayer picks moves with a Monte-Carlo tree search (see MctsTree): no
+// evaluation, just lots of quick games played out to the end from each move.
+class MctsPlayer : public Player {
+  MctsLimits limits;
+  unsigned seed;
+  mutable MctsTree tree;
+  mutable MctsResult last_result;
+  mutable std::atomic<bool> stop_requested;
+  mutable unsigned searches = 0;
+public:
+  // The tree has room for max_nodes nodes (24 bytes each). The playouts are
+  // seeded from seed and the number of moves played so far, so a game with
+  // a playout budget and one thread can be replayed.
+  MctsPlayer(Team team, MctsLimits limits = MctsLimits(), size_t max_nodes = 1 << 20, unsigned seed = 1);
+  Move get_move(const Board& board, const MoveList& moves) const override;
+  // Makes a get_move that is running on another thread (or the next one, if
+  // none is) return as soon as possible, with the best move it has found so
+  // far.
+  void stop() { stop_requested = true; }
+  // What the last call to get_move found out.
+  const MctsResult& last_search() const { return last_result; }
+};
+
+// BookPlayer plays the most played move in an opening book while the game is
+// still in the book, and lets another player pick the moves after that. The
+// book isn't copied, so it has to outlive the player, and many players (on
+// any number of threads) can share one. A BookPlayer plays one game.
+class BookPlayer : public Player {
+  const OpeningBook& book;
+  std::unique_ptr<Player> player;
+  mutable bool in_book = true;
+public:
+  // Plays for player's team.
+  BookPlayer(const OpeningBook& book, std::unique_ptr<Player> player);
+  Move get_move(const Board& board, const MoveList& moves) const override;
+  const char* name() const override { return player->name(); }
 };
 
 #endif  // _CHESS_PLAYER_H_
@@ -0,0 +1,156 @@
+#ifndef _EVALUATION_H_
+#define _EVALUATION_H_
+
+#include "bitboard.h"
+#include "chess_board.h"
+
+// Static evaluation: what the pieces are worth plus a bonus (or penalty) for
+// the cell each one stands on, in hundredths of a pawn. The Board adds up
+// piece_square_score for each piece as it is placed and removed (see
+// Board::score), so evaluating a position costs nothing and making a move
+// only a few adds.
+
+// How much each type of piece is worth. Kings aren't counted, because losing
+// the king loses the game.
+constexpr int PIECE_VALUES[NUM_PIECE_TYPES] = {
+    0,   // NO_PIECE
+    0,   // KING
+    900, // QUEEN
+    330, // BISHOP
+    320, // KNIGHT
+    500, // ROOK
+    100, // PAWN
+    150, // COWARDLY_DOG
+    800, // DARK_KNIGHT
+    300, // CUSTOM_PIECE
+};
+
+// Bonuses for a white piece on each cell, laid out like the board with rank 8
+// at the top. Black pieces use the same tables upside down.
+constexpr int PIECE_SQUARE_BONUSES[NUM_PIECE_TYPES][BOARD_SQUARES] = {
+    // NO_PIECE
+    {},
+    // KING: without check or castling, the king is safest behind its own
+    // pieces, away from the middle.
+    {-30, -40, -40, -50, -50, -40, -40, -30,
+     -30, -40, -40, -50, -50, -40, -40, -30,
+     -30, -40, -40, -50, -50, -40, -40, -30,
+     -30, -40, -40, -50, -50, -40, -40, -30,
+     -20, -30, -30, -40, -40, -30, -30, -20,
+     -10, -20, -20, -20, -20, -20, -20, -10,
+      10,  10,   0,   0,   0,   0,  10,  10,
+      20,  30,  10,   0,   0,  10,  30,  20},
+    // QUEEN
+    {-20, -10, -10,  -5,  -5, -10, -10, -20,
+     -10,   0,   0,   0,   0,   0,   0, -10,
+     -10,   0,   5,   5,   5,   5,   0, -10,
+      -5,   0,   5,   5,   5,   5,   0,  -5,
+       0,   0,   5,   5,   5,   5,   0,  -5,
+     -10,   5,   5,   5,   5,   5,   0, -10,
+     -10,   0,   5,   0,   0,   0,   0, -10,
+     -20, -10, -10,  -5,  -5, -10, -10, -20},
+    // BISHOP
+    {-20, -10, -10, -10, -10, -10, -10, -20,
+     -10,   0,   0,   0,   0,   0,   0, -10,
+     -10,   0,   5,  10,  10,   5,   0, -10,
+     -10,   5,   5,  10,  10,   5,   5, -10,
+     -10,   0,  10,  10,  10,  10,   0, -10,
+     -10,  10,  10,  10,  10,  10,  10, -10,
+     -10,   5,   0,   0,   0,   0,   5, -10,
+     -20, -10, -10, -10, -10, -10, -10, -20},
+    // KNIGHT
+    {-50, -40, -30, -30, -30, -30, -40, -50,
+     -40, -20,   0,   0,   0,   0, -20, -40,
+     -30,   0,  10,  15,  15,  10,   0, -30,
+     -30,   5,  15,  20,  20,  15,   5, -30,
+     -30,   0,  15,  20,  20,  15,   0, -30,
+     -30,   5,  10,  15,  15,  10,   5, -30,
+     -40, -20,   0,   5,   5,   0, -20, -40,
+     -50, -40, -30, -30, -30, -30, -40, -50},
+    // ROOK
+    {  0,   0,   0,   0,   0,   0,   0,   0,
+       5,  10,  10,  10,  10,  10,  10,   5,
+      -5,   0,   0,   0,   0,   0,   0,  -5,
+      -5,   0,   0,   0,   0,   0,   0,  -5,
+      -5,   0,   0,   0,   0,   0,   0,  -5,
+      -5,   0,   0,   0,   0,   0,   0,  -5,
+      -5,   0,   0,   0,   0,   0,   0,  -5,
+       0,   0,   0,   5,   5,   0,   0,   0},
+    // PAWN: pawns can't promote, so one stuck on the last rank is worth no
+    // more than one that hasn't moved.
+    {  0,   0,   0,   0,   0,   0,   0,   0,
+      30,  30,  30,  30,  30,  30,  30,  30,
+      10,  10,  20,  30,  30,  20,  10,  10,
+       5,   5,  10,  25,  25,  10,   5,   5,
+       0,   0,   0,  20,  20,   0,   0,   0,
+       5,  -5, -10,   0,   0, -10,  -5,   5,
+       0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0},
+    // COWARDLY_DOG: like a pawn, but he can always run home, so he's worth
+    // pushing further.
+    {  0,   0,   0,   0,   0,   0,   0,   0,
+      40,  40,  40,  40,  40,  40,  40,  40,
+      20,  20,  25,  30,  30,  25,  20,  20,
+      10,  10,  15,  25,  25,  15,  10,  10,
+       5,   5,  10,  20,  20,  10,   5,   5,
+       0,   0,   5,  10,  10,   5,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0,
+       0,   0,   0,   0,   0,   0,   0,   0},
+    // DARK_KNIGHT: his queen moves only go 4 cells and his knight jumps are
+    // short, so like a knight he wants the middle.
+    {-30, -20, -10, -10, -10, -10, -20, -30,
+     -20,   0,   5,   5,   5,   5,   0, -20,
+     -10,   5,  15,  20,  20,  15,   5, -10,
+     -10,   5,  20,  25,  25,  20,   5, -10,
+     -10,   5,  20,  25,  25,  20,   5, -10,
+     -10,   5,  15,  20,  20,  15,   5, -10,
+     -20,   0,   5,   5,   5,   5,   0, -20,
+     -30, -20, -10, -10, -10, -10, -20, -30},
+    // CUSTOM_PIECE: nobody knows how they move.
+    {},
+};
+
+// PIECE_VALUES plus PIECE_SQUARE_BONUSES for every PieceCode, from white's
+// point of view (so black pieces are negative).
+struct PieceSquareTable
+{
+    static constexpr int NUM_CODES = (WHITE << 4) + 16;
+
+    int scores[NUM_CODES][BOARD_SQUARES] = {};
+
+    constexpr int operator()(PieceCode code, int square) const { return scores[code][square]; }
+};
+
+constexpr PieceSquareTable piece_square_table()
+{
+    PieceSquareTable table;
+    for (int type = KING; type < NUM_PIECE_TYPES; ++type)
+    {
+        for (int square = 0; square < BOARD_SQUARES; ++square)
+        {
+            int x = square % 8, y = square / 8;
+            // The tables have rank 8 first, so white's rank y is row 7 - y.
+            int white_score = PIECE_VALUES[type] + PIECE_SQUARE_BONUSES[type][(7 - y) * 8 + x];
+            int black_score = PIECE_VALUES[type] + PIECE_SQUARE_BONUSES[type][y * 8 + x];
+            table.scores[make_piece_code(PieceType(type), WHITE)][square] = white_score;
+            table.scores[make_piece_code(PieceType(type), BLACK)][square] = -black_score;
+        }
+    }
+    return table;
+}
+
+inline constexpr PieceSquareTable PIECE_SQUARE_SCORES = piece_square_table();
+
+// What a piece of type and team on square adds to Board::score.
+constexpr int piece_square_score(PieceType type, Team team, int square)
+{
+    return PIECE_SQUARE_SCORES(make_piece_code(type, team), square);
+}
+
+// The score of board for the team whose turn it is, without searching.
+inline int evaluate(const Board& board)
+{
+    return board.turn() == WHITE ? board.score() : -board.score();
+}
+
+#endif // _EVALUATION_H_
@@ -0,0 +1,66 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "mapped_file.h"
+
+using std::runtime_error;
+using std::string;
+
+MappedFile::MappedFile(const string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("Can't open " + path + ": " + std::strerror(errno));
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0)
+    {
+        ::close(fd);
+        throw runtime_error("Can't read " + path + ": " + std::strerror(errno));
+    }
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+    if (file_size == 0)
+    {
+        // mmap can't map nothing.
+        ::close(fd);
+        return;
+    }
+    void* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw runtime_error("Can't map " + path + ": " + std::strerror(errno));
+    }
+    address = mapping;
+    length = file_size;
+}
+
+MappedFile::~MappedFile()
+{
+    if (address)
+    {
+        ::munmap(address, length);
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : address(std::exchange(other.address, nullptr)), length(std::exchange(other.length, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    std::swap(address, other.address);
+    std::swap(length, other.length);
+    return *this;
+}
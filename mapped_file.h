@@ -0,0 +1,31 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped into memory read-only. Nothing is read until it is
+// used, and every process that maps the same file shares one copy of it in
+// the page cache. mmap returns page aligned memory, so data() is aligned for
+// any type.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    // Throws runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const char* data() const { return static_cast<const char*>(address); }
+    size_t size() const { return length; }
+
+private:
+    void* address = nullptr;
+    size_t length = 0;
+};
+
+#endif // _MAPPED_FILE_H_
@@ -0,0 +1,257 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "chess_board.h"
+#include "chess_player.h"
+#include "mcts.h"
+
+using std::atomic;
+using std::ostream;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+MctsTree::MctsTree(size_t max_nodes)
+    : max_nodes(max_nodes), nodes(new Node[max_nodes]), start()
+{
+}
+
+void MctsTree::reset_node(Node& node, PackedMove move)
+{
+    // Nodes are reused from one search to the next, and only this thread can
+    // see them until their parent is EXPANDED.
+    node.move = move;
+    node.num_children = 0;
+    node.state.store(UNEXPANDED, std::memory_order_relaxed);
+    node.first_child = 0;
+    node.visits.store(0, std::memory_order_relaxed);
+    node.in_flight.store(0, std::memory_order_relaxed);
+    node.score.store(0, std::memory_order_relaxed);
+}
+
+bool MctsTree::allocate(size_t count, uint32_t& first)
+{
+    // Once the tree is full, used_nodes can go past max_nodes, but it never
+    // comes back down until the next search, so nothing is handed out twice.
+    size_t index = used_nodes.fetch_add(count, std::memory_order_relaxed);
+    if (index + count > max_nodes)
+    {
+        return false;
+    }
+    first = static_cast<uint32_t>(index);
+    return true;
+}
+
+void MctsTree::expand(Node& node, const Board& board)
+{
+    uint8_t expected = UNEXPANDED;
+    if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire))
+    {
+        return;
+    }
+    MoveList moves;
+    if (board.winner() == NONE)
+    {
+        moves = board.get_moves();
+    }
+    uint32_t first = 0;
+    if (!moves.empty() && !allocate(moves.size(), first))
+    {
+        // The tree is full: leave this node as a leaf for good.
+        return;
+    }
+    for (size_t i = 0; i < moves.size(); ++i)
+    {
+        reset_node(nodes[first + i], board.pack_move(moves[i]));
+    }
+    node.first_child = first;
+    node.num_children = static_cast<uint16_t>(moves.size());
+    // Publishes the children to the threads that see EXPANDED.
+    node.state.store(EXPANDED, std::memory_order_release);
+}
+
+uint32_t MctsTree::select_child(const Node& parent, double exploration) const
+{
+    uint32_t parent_visits = parent.visits.load(std::memory_order_relaxed) + parent.in_flight.load(std::memory_order_relaxed);
+    double log_parent_visits = std::log(parent_visits > 0 ? parent_visits : 1);
+    uint32_t best_child = parent.first_child;
+    double best_bound = -1;
+    for (uint32_t child = parent.first_child; child < parent.first_child + parent.num_children; ++child)
+    {
+        // Playouts still on their way through count as losses.
+        uint32_t visits = nodes[child].visits.load(std::memory_order_relaxed) + nodes[child].in_flight.load(std::memory_order_relaxed);
+        if (visits == 0)
+        {
+            return child;
+        }
+        double wins = nodes[child].score.load(std::memory_order_relaxed) / 2.0;
+        double bound = wins / visits + exploration * std::sqrt(log_parent_visits / visits);
+        if (bound > best_bound)
+        {
+            best_bound = bound;
+            best_child = child;
+        }
+    }
+    return best_child;
+}
+
+bool MctsTree::out_of_budget(const MctsLimits& limits)
+{
+    if (limits.playouts && started_playouts.fetch_add(1, std::memory_order_relaxed) >= limits.playouts)
+    {
+        return true;
+    }
+    return limits.milliseconds && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(limits.milliseconds);
+}
+
+// Plays board out to the end, with policy picking every move. Returns the
+// winner, or NONE for a draw.
+static Team play_out(Board& board, const Player& policy, int max_moves)
+{
+    for (int i = 0; i < max_moves; ++i)
+    {
+        Team winner = board.winner();
+        if (winner != NONE)
+        {
+            return winner;
+        }
+        MoveList moves = board.get_moves();
+        if (moves.empty())
+        {
+            return NONE;
+        }
+        // A team that can take the king has won, even if the policy
+        // wouldn't have noticed.
+        if (moves.captures_king())
+        {
+            return board.turn();
+        }
+        board.make_move(policy.get_move(board, moves));
+    }
+    return board.winner();
+}
+
+void MctsTree::run_playouts(const Board& root_board, const MctsLimits& limits, const atomic<bool>& stop, unsigned seed)
+{
+    unique_ptr<Player> policy;
+    if (limits.policy == RANDOM_ROLLOUTS)
+    {
+        policy.reset(new RandomPlayer(root_board.turn(), seed));
+    }
+    else
+    {
+        policy.reset(new CapturePlayer(root_board.turn(), seed));
+    }
+    Team root_team = root_board.turn();
+    vector<uint32_t> path;
+    for (bool first = true;; first = false)
+    {
+        // The first playout always runs, so there is a move to return.
+        bool stopped = stop.load(std::memory_order_relaxed);
+        if ((out_of_budget(limits) || stopped) && !first)
+        {
+            break;
+        }
+        Board board = root_board;
+        path.clear();
+        uint32_t index = 0;
+        path.push_back(index);
+        nodes[index].in_flight.fetch_add(1, std::memory_order_relaxed);
+        while (nodes[index].state.load(std::memory_order_acquire) == EXPANDED && nodes[index].num_children > 0)
+        {
+            index = select_child(nodes[index], limits.exploration);
+            nodes[index].in_flight.fetch_add(1, std::memory_order_relaxed);
+            board.make_move(nodes[index].move.move());
+            path.push_back(index);
+        }
+        expand(nodes[index], board);
+
+        Team winner = play_out(board, *policy, limits.max_rollout_moves);
+        Team other_team = root_team == WHITE ? BLACK : WHITE;
+        for (size_t depth = 0; depth < path.size(); ++depth)
+        {
+            Node& node = nodes[path[depth]];
+            // The node at depth was reached by a move of root_team if depth is odd.
+            Team mover = depth % 2 == 1 ? root_team : other_team;
+            uint32_t points = winner == NONE ? 1 : winner == mover ? 2 : 0;
+            node.score.fetch_add(points, std::memory_order_relaxed);
+            node.visits.fetch_add(1, std::memory_order_relaxed);
+            node.in_flight.fetch_sub(1, std::memory_order_relaxed);
+        }
+        finished_playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+MctsResult MctsTree::search(const Board& board, const MoveList& root_moves, const MctsLimits& limits,
+                            const atomic<bool>& stop, unsigned seed)
+{
+    start = std::chrono::steady_clock::now();
+    MctsResult result;
+    if (root_moves.captures_king() || root_moves.size() == 1)
+    {
+        result.best_move = root_moves.captures_king() ? root_moves.king_capture() : root_moves[0];
+        result.win_rate = root_moves.captures_king() ? 1 : 0;
+        return result;
+    }
+
+    // The root's children are root_moves, so the search can only pick one
+    // of them.
+    if (max_nodes < root_moves.size() + 1)
+    {
+        throw std::length_error("MctsTree has too few nodes for the moves in this position");
+    }
+    used_nodes = 1 + root_moves.size();
+    started_playouts = 0;
+    finished_playouts = 0;
+    Node& root = nodes[0];
+    reset_node(root, PackedMove());
+    root.first_child = 1;
+    root.num_children = static_cast<uint16_t>(root_moves.size());
+    for (size_t i = 0; i < root_moves.size(); ++i)
+    {
+        reset_node(nodes[1 + i], board.pack_move(root_moves[i]));
+    }
+    root.state = EXPANDED;
+
+    vector<thread> helpers;
+    for (int i = 1; i < limits.threads; ++i)
+    {
+        helpers.emplace_back([&, i]() { run_playouts(board, limits, stop, seed + static_cast<unsigned>(i)); });
+    }
+    run_playouts(board, limits, stop, seed);
+    for (thread& helper : helpers)
+    {
+        helper.join();
+    }
+
+    // The most visited move is the one the search trusts the most.
+    const Node* best = &nodes[root.first_child];
+    for (uint32_t child = root.first_child; child < root.first_child + root.num_children; ++child)
+    {
+        if (nodes[child].visits > best->visits)
+        {
+            best = &nodes[child];
+        }
+    }
+    result.best_move = best->move.move();
+    result.win_rate = best->visits ? best->score / 2.0 / best->visits : 0;
+    result.playouts = finished_playouts;
+    size_t used = used_nodes;
+    result.nodes = used < max_nodes ? used : max_nodes;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+ostream& operator<<(ostream& os, const MctsResult& result)
+{
+    return os << "move " << result.best_move << " win rate " << result.win_rate << " nodes " << result.nodes
+              << " playouts " << result.playouts << " playouts/s "
+              << static_cast<uint64_t>(result.seconds > 0 ? result.playouts / result.seconds : 0);
+}
@@ -0,0 +1,118 @@
+#ifndef _MCTS_H_
+#define _MCTS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+
+#include "chess_board.h"
+
+// How a playout picks its moves.
+enum RolloutPolicy
+{
+    RANDOM_ROLLOUTS, // any move, like RandomPlayer
+    CAPTURE_ROLLOUTS // a capture if there is one, like CapturePlayer
+};
+
+// When a Monte-Carlo tree search has to stop. It stops when the first budget
+// runs out, and always finishes at least one playout.
+struct MctsLimits
+{
+    int milliseconds = 1000; // wall-clock budget per move, 0 for no limit
+    uint64_t playouts = 0;   // playouts per move over all threads, 0 for no limit
+    int threads = 1;
+    RolloutPolicy policy = CAPTURE_ROLLOUTS;
+    // A playout that goes on for longer than this many moves is a draw.
+    int max_rollout_moves = 200;
+    // The UCT exploration constant. Higher values try the less promising
+    // moves more often.
+    double exploration = 1.4;
+};
+
+struct MctsResult
+{
+    Move best_move{};
+    uint64_t playouts = 0; // added up over all threads
+    size_t nodes = 0;      // tree nodes used
+    // The share of best_move's playouts that the team to move won (draws
+    // count as half).
+    double win_rate = 0;
+    double seconds = 0;
+};
+
+// Prints the move, win rate, nodes and playouts per second.
+std::ostream& operator<<(std::ostream& os, const MctsResult& result);
+
+// Monte-Carlo tree search with UCT: every playout walks down the tree picking
+// the child with the best upper confidence bound, adds the children of the
+// node it ends on, plays the game out to the end with the rollout policy and
+// counts the result in every node on the way back up. The moves with the
+// most playouts are the ones that kept winning, so no evaluation is needed.
+//
+// All threads share one tree. A playout on its way down counts as a loss in
+// every node it passes (a "virtual loss") until its result comes back, which
+// sends the other threads down different paths instead of piling onto the
+// same one. The counters are atomic, so there are no locks.
+//
+// The nodes come from one block allocated up front, and a search just
+// starts handing them out again from the beginning, so searching allocates
+// nothing. When they run out the tree stops growing and the playouts start
+// from its leaves.
+class MctsTree
+{
+public:
+    explicit MctsTree(size_t max_nodes = 1 << 20);
+
+    // Picks one of root_moves (the moves board.get_moves() returned). The
+    // search also stops as soon as stop becomes true. Thread i plays out with
+    // a random number generator seeded with seed + i, so a search on one
+    // thread with a playout budget is repeatable.
+    MctsResult search(const Board& board, const MoveList& root_moves, const MctsLimits& limits,
+                      const std::atomic<bool>& stop, unsigned seed);
+
+    size_t capacity() const { return max_nodes; }
+
+private:
+    enum NodeState : uint8_t
+    {
+        UNEXPANDED,
+        EXPANDING, // a thread is adding the children
+        EXPANDED   // the children are there (none if the game is over)
+    };
+
+    struct Node
+    {
+        PackedMove move{}; // the move that led here
+        uint16_t num_children = 0;
+        std::atomic<uint8_t> state{UNEXPANDED};
+        uint32_t first_child = 0;
+        std::atomic<uint32_t> visits{0};
+        std::atomic<uint32_t> in_flight{0}; // playouts on their way through
+        // In half points (a win is 2, a draw 1) for the team that made move.
+        std::atomic<uint32_t> score{0};
+    };
+
+    // Runs playouts until a budget runs out or stop becomes true.
+    void run_playouts(const Board& root_board, const MctsLimits& limits, const std::atomic<bool>& stop, unsigned seed);
+    // The child of parent with the best upper confidence bound.
+    uint32_t select_child(const Node& parent, double exploration) const;
+    // Adds the children of node (the moves on board) unless another thread is
+    // already doing it or the tree is full.
+    void expand(Node& node, const Board& board);
+    void reset_node(Node& node, PackedMove move);
+    // Hands out count nodes, or returns false if there is no room left.
+    bool allocate(size_t count, uint32_t& first);
+    bool out_of_budget(const MctsLimits& limits);
+
+    size_t max_nodes;
+    std::unique_ptr<Node[]> nodes;
+    std::atomic<size_t> used_nodes{0};
+    std::atomic<uint64_t> started_playouts{0};
+    std::atomic<uint64_t> finished_playouts{0};
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif // _MCTS_H_
@@ -0,0 +1,174 @@
+#include <algorithm>
+
+#include "chess_board.h"
+#include "evaluation.h"
+#include "move_picker.h"
+
+using std::swap;
+
+// History scores are halved when one gets this big, so old cutoffs fade and
+// the scores never overflow.
+const int HISTORY_LIMIT = 1 << 20;
+
+void MoveHistory::clear()
+{
+    for (auto& ply_killers : killers)
+    {
+        ply_killers[0] = ply_killers[1] = PackedMove();
+    }
+    for (auto& from_scores : history_scores)
+    {
+        for (int& score : from_scores)
+        {
+            score = 0;
+        }
+    }
+}
+
+void MoveHistory::record_cutoff(Move move, int ply, int depth)
+{
+    PackedMove packed(move);
+    if (ply < MAX_PLY && killers[ply][0] != packed)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = packed;
+    }
+    int& score = history_scores[packed.from_square()][packed.to_square()];
+    score += depth * depth;
+    if (score > HISTORY_LIMIT)
+    {
+        for (auto& from_scores : history_scores)
+        {
+            for (int& other_score : from_scores)
+            {
+                other_score /= 2;
+            }
+        }
+    }
+}
+
+// Captures of the most valuable victims come first, and of those, the ones
+// by the least valuable attackers. Capturing the king wins, so it beats
+// everything.
+static int capture_score(const Board& board, PackedMove move)
+{
+    if (move.is_king_capture())
+    {
+        return 1 << 30;
+    }
+    int victim = PIECE_VALUES[code_type(board.code(move.to_square()))];
+    int attacker = PIECE_VALUES[code_type(board.code(move.from_square()))];
+    return victim * 1024 - attacker;
+}
+
+MovePicker::MovePicker(const Board& board, MoveList& moves, const Move* hash_move, const MoveHistory& history, int ply)
+    : board(board), moves(moves), history(history), hash_move(hash_move ? *hash_move : Move()),
+      has_hash_move(hash_move != nullptr), ply(ply)
+{
+}
+
+Move MovePicker::take(size_t index)
+{
+    swap(moves[index], moves[next_index]);
+    swap(scores[index], scores[next_index]);
+    return moves[next_index++];
+}
+
+size_t MovePicker::best_index(size_t end) const
+{
+    size_t best = next_index;
+    for (size_t i = next_index + 1; i < end; ++i)
+    {
+        if (scores[i] > scores[best])
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool MovePicker::next(Move& move)
+{
+    switch (stage)
+    {
+    case HASH_MOVE:
+        stage = START_CAPTURES;
+        if (has_hash_move)
+        {
+            for (size_t i = 0; i < moves.size(); ++i)
+            {
+                if (moves[i] == hash_move)
+                {
+                    // No scores yet, so there are none to swap.
+                    swap(moves[i], moves[next_index]);
+                    move = moves[next_index++];
+                    return true;
+                }
+            }
+        }
+        [[fallthrough]];
+    case START_CAPTURES:
+        // Moves the captures to the front (after the hash move) and scores
+        // them. The other moves score 0 until their stage.
+        captures_end = next_index;
+        for (size_t i = next_index; i < moves.size(); ++i)
+        {
+            PackedMove packed = board.pack_move(moves[i]);
+            scores[i] = 0;
+            if (packed.is_capture())
+            {
+                swap(moves[i], moves[captures_end]);
+                scores[i] = scores[captures_end];
+                scores[captures_end] = capture_score(board, packed);
+                ++captures_end;
+            }
+        }
+        stage = CAPTURES;
+        [[fallthrough]];
+    case CAPTURES:
+        if (next_index < captures_end)
+        {
+            move = take(best_index(captures_end));
+            return true;
+        }
+        stage = KILLERS;
+        [[fallthrough]];
+    case KILLERS:
+        while (killer_index < 2)
+        {
+            PackedMove killer = history.killer(ply, killer_index++);
+            if (killer.empty())
+            {
+                continue;
+            }
+            for (size_t i = next_index; i < moves.size(); ++i)
+            {
+                if (PackedMove(moves[i]) == killer)
+                {
+                    move = take(i);
+                    return true;
+                }
+            }
+        }
+        stage = START_QUIETS;
+        [[fallthrough]];
+    case START_QUIETS:
+        for (size_t i = next_index; i < moves.size(); ++i)
+        {
+            scores[i] = history.history(moves[i]);
+        }
+        stage = QUIETS;
+        [[fallthrough]];
+    case QUIETS:
+        if (next_index < moves.size())
+        {
+            move = take(best_index(moves.size()));
+            return true;
+        }
+        stage = DONE;
+        [[fallthrough]];
+    case DONE:
+        break;
+    }
+    return false;
+}
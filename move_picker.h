@@ -0,0 +1,86 @@
+#ifndef _MOVE_PICKER_H_
+#define _MOVE_PICKER_H_
+
+#include "chess_board.h"
+
+// What a search has learned about which quiet moves (moves that don't
+// capture) cause cutoffs: the last two that did at each ply ("killer moves",
+// which often work again in the sibling positions) and a score for each from
+// and to pair that grows with every cutoff ("history").
+class MoveHistory
+{
+public:
+    static constexpr int MAX_PLY = 128;
+
+    MoveHistory() { clear(); }
+
+    void clear();
+    // Remembers that the quiet move caused a cutoff at ply, with depth left
+    // to search. Deeper cutoffs count for more.
+    void record_cutoff(Move move, int ply, int depth);
+
+    // The killer moves for ply, most recent first (empty if there are none).
+    PackedMove killer(int ply, int i) const { return ply < MAX_PLY ? killers[ply][i] : PackedMove(); }
+    int history(Move move) const { return history_scores[to_square(move.from)][to_square(move.to)]; }
+
+private:
+    PackedMove killers[MAX_PLY][2];
+    int history_scores[BOARD_SQUARES][BOARD_SQUARES];
+};
+
+// Hands out the moves of a MoveList best first, in stages:
+//   1. the hash move (the best move the transposition table remembers)
+//   2. captures, by most valuable victim and then least valuable attacker
+//      (MVV-LVA), with king captures before everything
+//   3. the killer moves for this ply
+//   4. the other quiet moves, by history score
+// Each call to next picks the best of the moves left in its stage with one
+// pass over them instead of sorting, so a node that cuts off after a move or
+// two never pays to order the rest.
+//
+// The picker reorders moves in place as it goes.
+class MovePicker
+{
+public:
+    // hash_move can be nullptr, and needn't be one of moves.
+    MovePicker(const Board& board, MoveList& moves, const Move* hash_move, const MoveHistory& history, int ply);
+
+    // Sets move to the next move and returns true, or returns false once
+    // every move has been handed out.
+    bool next(Move& move);
+
+private:
+    enum Stage
+    {
+        HASH_MOVE,
+        START_CAPTURES,
+        CAPTURES,
+        KILLERS,
+        START_QUIETS,
+        QUIETS,
+        DONE
+    };
+
+    // Moves the move at index to the front of the moves not handed out yet,
+    // and hands it out.
+    Move take(size_t index);
+    // The index of the best scored move in [next_index, end), which must not
+    // be empty.
+    size_t best_index(size_t end) const;
+
+    const Board& board;
+    MoveList& moves;
+    const MoveHistory& history;
+    Move hash_move;
+    bool has_hash_move;
+    int ply;
+    Stage stage = HASH_MOVE;
+    int killer_index = 0;
+    // Everything before next_index has been handed out. The captures are
+    // [next_index, captures_end) while they're being handed out.
+    size_t next_index = 0;
+    size_t captures_end = 0;
+    int scores[MoveList::CAPACITY];
+};
+
+#endif // _MOVE_PICKER_H_
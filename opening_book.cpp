@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chess_board.h"
+#include "opening_book.h"
+
+using std::pair;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+const size_t BOOK_HEADER_SIZE = 16;
+
+// The order of a book file: by hash, then most played first, then best
+// scoring first, then by move so the same games always make the same file.
+static bool entry_before(const BookEntry& a, const BookEntry& b)
+{
+    if (a.hash != b.hash)
+    {
+        return a.hash < b.hash;
+    }
+    if (a.games != b.games)
+    {
+        return a.games > b.games;
+    }
+    return a.score != b.score ? a.score > b.score : a.move < b.move;
+}
+
+OpeningBook::OpeningBook(const string& path)
+    : file(path)
+{
+    uint64_t count = 0;
+    if (file.size() >= BOOK_HEADER_SIZE)
+    {
+        std::memcpy(&count, file.data() + sizeof(BOOK_MAGIC), sizeof(count));
+    }
+    if (file.size() < BOOK_HEADER_SIZE || std::memcmp(file.data(), BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 ||
+        (file.size() - BOOK_HEADER_SIZE) % sizeof(BookEntry) != 0 ||
+        (file.size() - BOOK_HEADER_SIZE) / sizeof(BookEntry) != count)
+    {
+        throw runtime_error(path + " isn't an opening book");
+    }
+    entries = reinterpret_cast<const BookEntry*>(file.data() + BOOK_HEADER_SIZE);
+    num_entries = static_cast<size_t>(count);
+}
+
+pair<const BookEntry*, const BookEntry*> OpeningBook::find(uint64_t hash) const
+{
+    BookEntry key{hash, 0, 0, 0};
+    return std::equal_range(entries, entries + num_entries, key,
+                            [](const BookEntry& a, const BookEntry& b) { return a.hash < b.hash; });
+}
+
+bool OpeningBook::probe(const Board& board, Move& move) const
+{
+    auto range = find(board.hash());
+    for (const BookEntry* entry = range.first; entry != range.second; ++entry)
+    {
+        PackedMove packed;
+        packed.bits = entry->move;
+        if (board.is_legal(packed.move()))
+        {
+            move = packed.move();
+            return true;
+        }
+    }
+    return false;
+}
+
+void OpeningBookBuilder::add_game(const vector<Move>& moves, Team winner)
+{
+    Board board;
+    int plies = std::min(max_plies, static_cast<int>(moves.size()));
+    for (int ply = 0; ply < plies; ++ply)
+    {
+        Move move = moves[static_cast<size_t>(ply)];
+        if (!board.is_legal(move))
+        {
+            std::ostringstream message;
+            message << "Illegal move " << move << " in game " << num_games + 1;
+            throw runtime_error(message.str());
+        }
+        MoveStats& move_stats = stats[{board.hash(), board.pack_move(move).bits}];
+        ++move_stats.games;
+        move_stats.points += winner == NONE ? 1u : winner == board.turn() ? 2u : 0u;
+        board.make_move(move);
+    }
+    ++num_games;
+}
+
+bool OpeningBookBuilder::add_game(const string& line)
+{
+    std::istringstream words(line);
+    vector<string> game;
+    string word;
+    while (words >> word)
+    {
+        game.push_back(word);
+    }
+    if (game.empty() || (game.back() != "1-0" && game.back() != "0-1" && game.back() != "1/2-1/2"))
+    {
+        return false;
+    }
+    vector<Move> moves;
+    for (size_t i = 0; i + 1 < game.size(); ++i)
+    {
+        std::istringstream move_text(game[i]);
+        Move move;
+        if (!(move_text >> move) || move_text.peek() != EOF)
+        {
+            throw runtime_error("Not a move: " + game[i]);
+        }
+        moves.push_back(move);
+    }
+    add_game(moves, game.back() == "1-0" ? WHITE : game.back() == "0-1" ? BLACK : NONE);
+    return true;
+}
+
+vector<BookEntry> OpeningBookBuilder::entries(uint32_t min_games) const
+{
+    vector<BookEntry> result;
+    for (const auto& key_and_stats : stats)
+    {
+        const MoveStats& move_stats = key_and_stats.second;
+        if (move_stats.games < min_games)
+        {
+            continue;
+        }
+        // points is in half points, so 500 per half point of the average.
+        uint64_t score = uint64_t(move_stats.points) * 500 / move_stats.games;
+        result.push_back(BookEntry{key_and_stats.first.first, move_stats.games, key_and_stats.first.second,
+                                   static_cast<uint16_t>(score)});
+    }
+    std::sort(result.begin(), result.end(), entry_before);
+    return result;
+}
+
+size_t OpeningBookBuilder::write(const string& path, uint32_t min_games) const
+{
+    vector<BookEntry> book = entries(min_games);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    uint64_t count = book.size();
+    file.write(BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(book.data()), static_cast<std::streamsize>(book.size() * sizeof(BookEntry)));
+    file.close();
+    if (!file)
+    {
+        throw runtime_error("Can't write opening book " + path);
+    }
+    return book.size();
+}
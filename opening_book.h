@@ -0,0 +1,106 @@
+#ifndef _OPENING_BOOK_H_
+#define _OPENING_BOOK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chess_board.h"
+#include "mapped_file.h"
+
+// One move from one position in an opening book, with how it did in the
+// games it was played in.
+struct BookEntry
+{
+    uint64_t hash;   // Board::hash() of the position
+    uint32_t games;  // how many games played move from the position
+    uint16_t move;   // PackedMove::bits
+    uint16_t score;  // the points the team that moved got, in thousandths
+};
+
+static_assert(sizeof(BookEntry) == 16, "BookEntry is written to book files as it is");
+
+// An opening book file is a 16 byte header (BOOK_MAGIC and then the number
+// of entries as a uint64_t) followed by the BookEntries, sorted by hash and
+// then by games, most first. Everything is in the byte order of the machine
+// that wrote it, so the file can be used straight from memory. The magic is
+// bytes, so it reads the same in either byte order, but a file from a machine
+// with the other byte order has its entry count byte swapped, which then
+// doesn't match the size of the file.
+constexpr char BOOK_MAGIC[8] = {'S', 'C', 'B', 'O', 'O', 'K', '1', '\0'};
+
+// A read-only opening book, memory-mapped from a file. Opening it doesn't
+// read or parse anything, and every process that maps the same file shares
+// one copy of it in the page cache. Lookups are binary searches.
+//
+// Nothing changes after the constructor, so any number of threads can use
+// one OpeningBook at once.
+class OpeningBook
+{
+public:
+    // An empty book, which never has a move.
+    OpeningBook() = default;
+    // Maps the book at path. Throws runtime_error if the file can't be opened
+    // or isn't a book.
+    explicit OpeningBook(const std::string& path);
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    size_t size() const { return num_entries; }
+    bool empty() const { return num_entries == 0; }
+
+    // The entries for the position with hash, most played first (an empty
+    // range if there are none).
+    std::pair<const BookEntry*, const BookEntry*> find(uint64_t hash) const;
+    // Sets move to the most played book move for board and returns true, or
+    // returns false if the book has no legal move for board. (Checking that
+    // the move is legal guards against two positions with the same hash.)
+    bool probe(const Board& board, Move& move) const;
+
+private:
+    MappedFile file{};
+    const BookEntry* entries = nullptr;
+    size_t num_entries = 0;
+};
+
+// Collects the opening moves of finished games and turns them into a book.
+class OpeningBookBuilder
+{
+public:
+    // Only the first max_plies moves of each game go in the book.
+    explicit OpeningBookBuilder(int max_plies = 16) : max_plies(max_plies), stats() {}
+
+    // Adds a game that started from the starting position.
+    void add_game(const std::vector<Move>& moves, Team winner);
+    // Adds a game from a GameLog line at LOG_MOVES ("b1c3 g8f6 ... 1-0").
+    // Returns false (adding nothing) if line doesn't end with a result, so
+    // other lines can be skipped, and throws runtime_error if a game has a
+    // move that isn't legal.
+    bool add_game(const std::string& line);
+
+    // The number of games added so far.
+    uint64_t games() const { return num_games; }
+    // The book, leaving out moves played in fewer than min_games games,
+    // sorted as a book file wants it.
+    std::vector<BookEntry> entries(uint32_t min_games = 1) const;
+    // Writes entries(min_games) to path and returns how many there were.
+    // Throws runtime_error if it can't.
+    size_t write(const std::string& path, uint32_t min_games = 1) const;
+
+private:
+    struct MoveStats
+    {
+        uint32_t games = 0;
+        uint32_t points = 0; // in half points: 2 for a win, 1 for a draw
+    };
+
+    int max_plies;
+    uint64_t num_games = 0;
+    // Keyed by position hash and PackedMove::bits.
+    std::map<std::pair<uint64_t, uint16_t>, MoveStats> stats;
+};
+
+#endif // _OPENING_BOOK_H_
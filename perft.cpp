@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "basic_board.h"
+#include "chess_board.h"
+#include "perft.h"
+
+using std::pair;
+using std::vector;
+
+template <class BoardType>
+uint64_t perft(BoardType& board, int depth)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+    if (board.winner() != NONE)
+    {
+        return 0;
+    }
+    typename BoardType::MoveList moves = board.get_moves();
+    if (depth == 1)
+    {
+        return moves.size();
+    }
+    uint64_t nodes = 0;
+    for (Move move : moves)
+    {
+        UndoRecord undo = board.make_move(move);
+        nodes += perft(board, depth - 1);
+        board.unmake_move(undo);
+    }
+    return nodes;
+}
+
+template <class BoardType>
+vector<pair<Move, uint64_t> > perft_divide(BoardType& board, int depth)
+{
+    vector<pair<Move, uint64_t> > counts;
+    if (depth == 0 || board.winner() != NONE)
+    {
+        return counts;
+    }
+    typename BoardType::MoveList moves = board.get_moves();
+    for (Move move : moves)
+    {
+        UndoRecord undo = board.make_move(move);
+        counts.emplace_back(move, perft(board, depth - 1));
+        board.unmake_move(undo);
+    }
+    return counts;
+}
+
+template uint64_t perft(Board&, int);
+template uint64_t perft(BasicBoard<10, 10>&, int);
+template uint64_t perft(BasicBoard<12, 12>&, int);
+template vector<pair<Move, uint64_t> > perft_divide(Board&, int);
+template vector<pair<Move, uint64_t> > perft_divide(BasicBoard<10, 10>&, int);
+template vector<pair<Move, uint64_t> > perft_divide(BasicBoard<12, 12>&, int);
@@ -0,0 +1,30 @@
+#ifndef _PERFT_H_
+#define _PERFT_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "chess_board.h"
+
+using std::pair;
+using std::vector;
+
+// Counts the positions reached by playing every possible sequence of depth
+// moves from board. Once a king has been captured the game is over, so those
+// positions have no moves after them. board is back the way it started when
+// this returns.
+//
+// Comparing these counts with known good ones is how we check that move
+// generation is still correct after making it faster.
+//
+// Works on a Board or any other BasicBoard that visit_board can make (the
+// others are instantiated in perft.cpp).
+template <class BoardType>
+uint64_t perft(BoardType& board, int depth);
+
+// The same count as perft, split up by the first move.
+template <class BoardType>
+vector<pair<Move, uint64_t> > perft_divide(BoardType& board, int depth);
+
+#endif // _PERFT_H_
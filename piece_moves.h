@@ -0,0 +1,276 @@
+#ifndef _PIECE_MOVES_H_
+#define _PIECE_MOVES_H_
+
+#include <algorithm>
+
+#include "attack_tables.h"
+#include "bitboard.h"
+#include "chess_board.h"
+#include "chess_pieces.h"
+#include "sliding_attacks.h"
+
+// Move generation for the built in pieces.
+//
+// The rules are written once, as templates over a Geometry that knows how to
+// find cells on one size of board. A Geometry has a Targets type (a set of
+// cells, numbered y * cols + x) and these members:
+//   empty(), enemies(team), pieces(type)  the cells with no piece, with a
+//                                         piece team can capture, or with a
+//                                         piece of type
+//   king_steps(cell), knight_jumps(cell)  the cells one jump away
+//   rook_lines(cell), bishop_lines(cell)  each line up to and including the
+//                                         first piece on it
+//   open_lines(cell)                      a queen's lines, ignoring pieces
+//   near(cell)                            the cells DARK_KNIGHT_RANGE king
+//                                         steps away or closer
+//   pawn_push(cell, steps), pawn_attacks(cell, steps)
+//                                         the cell steps rows ahead, and the
+//                                         ones diagonally next to it
+//   file_run(cell, steps)                 every cell steps, 2 * steps, ...
+//                                         rows ahead, up to the edge
+//   any(targets), pop_first(targets)      for looping over targets
+//   count(targets)                        how many cells targets has
+//   NUM_CELLS                             how many cells the board has
+// A Board uses BitboardGeometry (below), which looks everything up in tables,
+// and the bigger BasicBoards use a CellGeometry (in basic_board.h), which
+// walks from cell to cell.
+
+template <class Geometry>
+typename Geometry::Targets empty_or_enemy(const Geometry& board, Team team)
+{
+    return board.empty() | board.enemies(team);
+}
+
+template <class Geometry>
+typename Geometry::Targets king_targets(const Geometry& board, int cell, Team team)
+{
+    return board.king_steps(cell) & empty_or_enemy(board, team);
+}
+
+template <class Geometry>
+typename Geometry::Targets queen_targets(const Geometry& board, int cell, Team team)
+{
+    return (board.rook_lines(cell) | board.bishop_lines(cell)) & empty_or_enemy(board, team);
+}
+
+template <class Geometry>
+typename Geometry::Targets bishop_targets(const Geometry& board, int cell, Team team)
+{
+    return board.bishop_lines(cell) & empty_or_enemy(board, team);
+}
+
+template <class Geometry>
+typename Geometry::Targets knight_targets(const Geometry& board, int cell, Team team)
+{
+    return board.knight_jumps(cell) & empty_or_enemy(board, team);
+}
+
+template <class Geometry>
+typename Geometry::Targets rook_targets(const Geometry& board, int cell, Team team)
+{
+    return board.rook_lines(cell) & empty_or_enemy(board, team);
+}
+
+// y_move_steps is how many rows the pawn moves at a time (see forward_steps).
+template <class Geometry>
+typename Geometry::Targets pawn_targets(const Geometry& board, int cell, Team team, int y_move_steps)
+{
+    return (board.pawn_push(cell, y_move_steps) & board.empty()) |
+           (board.pawn_attacks(cell, y_move_steps) & board.enemies(team));
+}
+
+// A CowardlyDog moves like a pawn, but can also flee backwards.
+template <class Geometry>
+typename Geometry::Targets cowardly_dog_targets(const Geometry& board, int cell, Team team, int y_move_steps)
+{
+    // mah boi can hop over pieces to run away, so every empty cell behind him will do
+    return pawn_targets(board, cell, team, y_move_steps) | (board.file_run(cell, -y_move_steps) & board.empty());
+}
+
+// The cells a DarkKnight on cell can reach, whoever is on them.
+template <class Geometry>
+typename Geometry::Targets dark_knight_reach(const Geometry& board, int cell)
+{
+    /* Gotham's greatest hero can move in all 8 directions just like a queen, although only up to 4 tiles.
+
+       The Dark Knight can also move like a knight would. BECAUSE HES BATMAN!!!
+
+       Finally, if a rook (of either team) is within his queen moveset direction with unlimited range,
+       he is able to land in any tile adjacent to that rook,
+       via his grapple gun, even if a piece is blocking the path to the rook. BECAUSE HE'S BATTTMAAAAANN!!!!
+    */
+    typename Geometry::Targets reach = (board.rook_lines(cell) | board.bishop_lines(cell)) & board.near(cell);
+    reach |= board.knight_jumps(cell);
+
+    // The board keeps track of where the rooks are, so we only look at the
+    // ones on his lines. Nothing blocks the grapple gun, so those are the
+    // lines of a queen on an empty board.
+    typename Geometry::Targets rooks = board.pieces(ROOK) & board.open_lines(cell);
+    while (board.any(rooks))
+    {
+        reach |= board.king_steps(board.pop_first(rooks));
+    }
+
+    return reach;
+}
+
+template <class Geometry>
+typename Geometry::Targets dark_knight_targets(const Geometry& board, int cell, Team team)
+{
+    // Moves that more than one rule allows are only added once.
+    return dark_knight_reach(board, cell) & empty_or_enemy(board, team);
+}
+
+// The cells the built in piece with code on cell can move to, or none for a
+// custom piece (only its own get_moves knows).
+template <class Geometry>
+typename Geometry::Targets piece_targets(const Geometry& board, PieceCode code, int cell)
+{
+    Team team = code_team(code);
+    switch (code_type(code))
+    {
+    case KING:
+        return king_targets(board, cell, team);
+    case QUEEN:
+        return queen_targets(board, cell, team);
+    case BISHOP:
+        return bishop_targets(board, cell, team);
+    case KNIGHT:
+        return knight_targets(board, cell, team);
+    case ROOK:
+        return rook_targets(board, cell, team);
+    case PAWN:
+        return pawn_targets(board, cell, team, forward_steps(team));
+    case COWARDLY_DOG:
+        return cowardly_dog_targets(board, cell, team, forward_steps(team));
+    case DARK_KNIGHT:
+        return dark_knight_targets(board, cell, team);
+    default:
+        return typename Geometry::Targets();
+    }
+}
+
+// The most moves a built in piece of type can ever have on the board whose
+// Geometry is empty_board (with no pieces on it): as many as from its best
+// cell with nothing in the way and something to capture wherever it attacks,
+// except a DarkKnight, whose grapple gun could take it to any other cell.
+template <class Geometry>
+int most_moves(const Geometry& empty_board, PieceType type)
+{
+    if (type == DARK_KNIGHT)
+    {
+        return Geometry::NUM_CELLS - 1;
+    }
+    int steps = forward_steps(WHITE);
+    int most = 0;
+    for (int cell = 0; cell < Geometry::NUM_CELLS; ++cell)
+    {
+        typename Geometry::Targets reach = typename Geometry::Targets();
+        switch (type)
+        {
+        case KING:
+            reach = empty_board.king_steps(cell);
+            break;
+        case QUEEN:
+            reach = empty_board.rook_lines(cell) | empty_board.bishop_lines(cell);
+            break;
+        case BISHOP:
+            reach = empty_board.bishop_lines(cell);
+            break;
+        case KNIGHT:
+            reach = empty_board.knight_jumps(cell);
+            break;
+        case ROOK:
+            reach = empty_board.rook_lines(cell);
+            break;
+        case PAWN:
+            reach = empty_board.pawn_push(cell, steps) | empty_board.pawn_attacks(cell, steps);
+            break;
+        case COWARDLY_DOG:
+            reach = empty_board.pawn_push(cell, steps) | empty_board.pawn_attacks(cell, steps) |
+                    empty_board.file_run(cell, -steps);
+            break;
+        default:
+            break;
+        }
+        most = std::max(most, empty_board.count(reach));
+    }
+    return most;
+}
+
+// The most moves team's pieces in text could ever have, on the board whose
+// Geometry is empty_board. The built in pieces never add material, and a
+// capture only takes a piece (and its most_moves) away, so however their game
+// goes this never grows.
+template <class Geometry>
+int most_team_moves(const Geometry& empty_board, const BoardText& text, Team team)
+{
+    int most = 0;
+    for (const ChessPiece* piece : text.cells)
+    {
+        if (piece->team == team)
+        {
+            most += most_moves(empty_board, piece->type);
+        }
+    }
+    return most;
+}
+
+// The cells holding pieces that team can capture.
+inline Bitboard enemies(const Board& board, Team team)
+{
+    switch (team)
+    {
+    case WHITE:
+        return board.pieces(BLACK);
+    case BLACK:
+        return board.pieces(WHITE);
+    default:
+        return 0;
+    }
+}
+
+// The Geometry of a Board: the Targets are Bitboards, and the cells a piece
+// can reach come from the tables in attack_tables.h and sliding_attacks.h.
+class BitboardGeometry
+{
+public:
+    typedef Bitboard Targets;
+
+    static constexpr int NUM_CELLS = BOARD_SQUARES;
+
+    explicit BitboardGeometry(const Board& board) : board(board) {}
+
+    Bitboard empty() const { return ~board.occupancy(); }
+    Bitboard enemies(Team team) const { return ::enemies(board, team); }
+    Bitboard pieces(PieceType type) const { return board.pieces(type); }
+
+    static Bitboard king_steps(int square) { return KING_ATTACKS[square]; }
+    static Bitboard knight_jumps(int square) { return KNIGHT_ATTACKS[square]; }
+    Bitboard rook_lines(int square) const { return rook_attacks(square, board.occupancy()); }
+    Bitboard bishop_lines(int square) const { return bishop_attacks(square, board.occupancy()); }
+    static Bitboard open_lines(int square) { return queen_attacks(square, 0); }
+    static Bitboard near(int square) { return DARK_KNIGHT_REACH[square]; }
+    static Bitboard pawn_push(int square, int steps) { return PAWN_PUSHES[step_table_index(steps)][square]; }
+    static Bitboard pawn_attacks(int square, int steps) { return PAWN_ATTACKS[step_table_index(steps)][square]; }
+    static Bitboard file_run(int square, int steps) { return FILE_RAYS[step_table_index(steps)][square]; }
+
+    static bool any(Bitboard targets) { return targets != 0; }
+    static int pop_first(Bitboard& targets) { return pop_lowest_square(targets); }
+    static int count(Bitboard targets) { return count_squares(targets); }
+
+private:
+    const Board& board;
+};
+
+// Adds a move from square to each cell in targets.
+inline void add_moves(int square, Bitboard targets, MoveList& moves)
+{
+    Cell from = to_cell(square);
+    while (targets)
+    {
+        moves.emplace_back(from, to_cell(pop_lowest_square(targets)));
+    }
+}
+
+#endif // _PIECE_MOVES_H_
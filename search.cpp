@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bitboard.h"
+#include "chess_board.h"
+#include "evaluation.h"
+#include "move_picker.h"
+#include "search.h"
+#include "tablebase.h"
+#include "transposition_table.h"
+
+using std::abs;
+using std::atomic;
+using std::ostream;
+using std::thread;
+using std::vector;
+
+// Scores this close to WIN_SCORE mean somebody's king gets captured.
+const int WIN_SCORE_THRESHOLD = WIN_SCORE - 1000;
+
+// How much better than the piece it wins a capture can turn out (from the
+// piece-square bonuses), for delta pruning in quiescence.
+const int DELTA_MARGIN = 200;
+
+// Winning scores count moves from the root of the search, but the same
+// position can be reached at different distances from the root, so the table
+// stores them counted from the position itself.
+static int score_to_table(int score, int ply)
+{
+    if (score >= WIN_SCORE_THRESHOLD)
+    {
+        return score + ply;
+    }
+    if (score <= -WIN_SCORE_THRESHOLD)
+    {
+        return score - ply;
+    }
+    return score;
+}
+
+static int score_from_table(int score, int ply)
+{
+    if (score >= WIN_SCORE_THRESHOLD)
+    {
+        return score - ply;
+    }
+    if (score <= -WIN_SCORE_THRESHOLD)
+    {
+        return score + ply;
+    }
+    return score;
+}
+
+// Puts moves in the order a MovePicker would hand them out, for the root,
+// which goes over its moves again at every depth.
+static void order_moves(const Board& board, MoveList& moves, const Move* first_move, const MoveHistory& history)
+{
+    MoveList ordered;
+    MovePicker picker(board, moves, first_move, history, 0);
+    Move move;
+    while (picker.next(move))
+    {
+        ordered.push_back(move);
+    }
+    moves = ordered;
+}
+
+// A tablebase result for the position at ply, as a score counted from the
+// root like the other winning scores.
+static int tablebase_score(TablebaseResult result, int ply)
+{
+    switch (result.outcome)
+    {
+    case TABLEBASE_WIN:
+        return WIN_SCORE - (ply + result.plies);
+    case TABLEBASE_LOSS:
+        return -(WIN_SCORE - (ply + result.plies));
+    default:
+        return 0;
+    }
+}
+
+Search::Search(TranspositionTable& table, SearchLimits limits, const atomic<bool>* stop, int thread_index)
+    : table(table), history(), limits(limits), stop_signal(stop), thread_index(thread_index), start()
+{
+}
+
+bool Search::out_of_budget()
+{
+    if (root_depth == 1)
+    {
+        return false;
+    }
+    if (stop_signal && stop_signal->load(std::memory_order_relaxed))
+    {
+        stopped = true;
+    }
+    else if (limits.nodes && nodes >= limits.nodes)
+    {
+        stopped = true;
+    }
+    else if (limits.milliseconds && (nodes & 1023) == 0)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stopped = elapsed >= std::chrono::milliseconds(limits.milliseconds);
+    }
+    return stopped;
+}
+
+int Search::negamax(Board& board, int depth, int ply, int alpha, int beta)
+{
+    ++nodes;
+    if (out_of_budget())
+    {
+        return 0;
+    }
+    if (board.winner() != NONE)
+    {
+        // The last move captured our king.
+        return -(WIN_SCORE - ply);
+    }
+    TablebaseResult tablebase_result;
+    if (limits.tablebases && limits.tablebases->probe(board, tablebase_result))
+    {
+        return tablebase_score(tablebase_result, ply);
+    }
+    if (depth == 0)
+    {
+        return limits.quiescence ? quiescence(board, ply, alpha, beta) : evaluate(board);
+    }
+
+    const int original_alpha = alpha;
+    TableEntry entry;
+    bool has_table_move = false;
+    if (table.probe(board.hash(), entry))
+    {
+        has_table_move = entry.has_best_move;
+        if (entry.depth >= depth)
+        {
+            int score = score_from_table(entry.score, ply);
+            if (entry.bound == BOUND_EXACT ||
+                (entry.bound == BOUND_LOWER && score >= beta) ||
+                (entry.bound == BOUND_UPPER && score <= alpha))
+            {
+                return score;
+            }
+        }
+    }
+
+    MoveList moves = board.get_moves();
+    if (moves.empty())
+    {
+        return 0;
+    }
+    if (moves.captures_king())
+    {
+        // We win on the next move, and nothing can do better than that.
+        return WIN_SCORE - (ply + 1);
+    }
+    MovePicker picker(board, moves, has_table_move ? &entry.best_move : nullptr, history, ply);
+
+    int best_score = -INFINITE_SCORE;
+    Move best_move = moves[0];
+    Move move;
+    while (picker.next(move))
+    {
+        UndoRecord undo = board.make_move(move);
+        int score = -negamax(board, depth - 1, ply + 1, -beta, -alpha);
+        board.unmake_move(undo);
+        if (stopped)
+        {
+            return 0;
+        }
+        if (score > best_score)
+        {
+            best_score = score;
+            best_move = move;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta)
+        {
+            if (!board.pack_move(move).is_capture())
+            {
+                history.record_cutoff(move, ply, depth);
+            }
+            break;
+        }
+    }
+
+    Bound bound = best_score >= beta ? BOUND_LOWER : best_score > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+    table.store(board.hash(), depth, score_to_table(best_score, ply), bound, &best_move);
+    return best_score;
+}
+
+int Search::quiescence(Board& board, int ply, int alpha, int beta)
+{
+    ++nodes;
+    if (out_of_budget())
+    {
+        return 0;
+    }
+    if (board.winner() != NONE)
+    {
+        return -(WIN_SCORE - ply);
+    }
+    MoveList captures = board.get_captures();
+    if (captures.captures_king())
+    {
+        return WIN_SCORE - (ply + 1);
+    }
+    int stand_pat = evaluate(board);
+    // Custom pieces can capture without using up pieces, so this has to
+    // stop somewhere.
+    if (stand_pat >= beta || ply >= MoveHistory::MAX_PLY)
+    {
+        return stand_pat;
+    }
+    alpha = std::max(alpha, stand_pat);
+
+    int best_score = stand_pat;
+    MovePicker picker(board, captures, nullptr, history, ply);
+    Move move;
+    while (picker.next(move))
+    {
+        // Delta pruning: skip captures that can't raise alpha even if they
+        // win the piece for nothing.
+        int gain = PIECE_VALUES[code_type(board.code(to_square(move.to)))];
+        if (stand_pat + gain + DELTA_MARGIN <= alpha)
+        {
+            continue;
+        }
+        UndoRecord undo = board.make_move(move);
+        int score = -quiescence(board, ply + 1, -beta, -alpha);
+        board.unmake_move(undo);
+        if (stopped)
+        {
+            return 0;
+        }
+        if (score > best_score)
+        {
+            best_score = score;
+        }
+        if (score >= beta)
+        {
+            break;
+        }
+        alpha = std::max(alpha, score);
+    }
+    return best_score;
+}
+
+bool Search::search_root(Board& board, MoveList& root_moves, int depth, Move& best_move, int& best_score)
+{
+    int alpha = -INFINITE_SCORE;
+    bool finished_any = false;
+    for (Move move : root_moves)
+    {
+        UndoRecord undo = board.make_move(move);
+        int score = -negamax(board, depth - 1, 1, -INFINITE_SCORE, -alpha);
+        board.unmake_move(undo);
+        if (stopped)
+        {
+            break;
+        }
+        if (!finished_any || score > alpha)
+        {
+            alpha = score;
+            best_move = move;
+            best_score = score;
+        }
+        finished_any = true;
+    }
+    return finished_any;
+}
+
+SearchResult Search::run(const Board& root_board, const MoveList& root_moves)
+{
+    start = std::chrono::steady_clock::now();
+    nodes = 0;
+    stopped = false;
+
+    history.clear();
+
+    Board board = root_board;
+    MoveList moves = root_moves;
+    order_moves(board, moves, nullptr, history);
+
+    SearchResult result;
+    result.best_move = moves[0];
+    // Helper threads skip depth 1 every other thread, so they don't all search
+    // the same depth at the same time.
+    int first_depth = 1 + thread_index % 2;
+    for (root_depth = first_depth; root_depth <= limits.depth; ++root_depth)
+    {
+        Move best_move;
+        int best_score;
+        if (search_root(board, moves, root_depth, best_move, best_score))
+        {
+            // Even when the search was stopped part way through, the moves it
+            // did finish were compared against the previous best move (which
+            // is searched first), so best_move is still the best we know of.
+            result.best_move = best_move;
+            result.score = best_score;
+            order_moves(board, moves, &best_move, history);
+        }
+        if (stopped)
+        {
+            break;
+        }
+        result.depth = root_depth;
+        if (abs(result.score) >= WIN_SCORE_THRESHOLD)
+        {
+            // Searching deeper won't change a forced win or loss.
+            break;
+        }
+    }
+    result.nodes = nodes;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.thread_nodes.assign(1, nodes);
+    return result;
+}
+
+SearchResult parallel_search(TranspositionTable& table, SearchLimits limits, int num_threads,
+                             const Board& board, const MoveList& root_moves,
+                             const atomic<bool>& stop)
+{
+    // The helpers stop when the main thread is done, which is either when its
+    // limits run out or when stop becomes true.
+    atomic<bool> stop_helpers(false);
+    vector<SearchResult> helper_results(num_threads > 1 ? static_cast<size_t>(num_threads - 1) : 0);
+    vector<thread> helpers;
+    for (int i = 1; i < num_threads; ++i)
+    {
+        helpers.emplace_back([&, i]() {
+            SearchLimits helper_limits = limits;
+            helper_limits.milliseconds = 0;
+            Search search(table, helper_limits, &stop_helpers, i);
+            helper_results[static_cast<size_t>(i - 1)] = search.run(board, root_moves);
+        });
+    }
+
+    Search search(table, limits, &stop, 0);
+    SearchResult result = search.run(board, root_moves);
+    stop_helpers = true;
+    for (thread& helper : helpers)
+    {
+        helper.join();
+    }
+    for (const SearchResult& helper_result : helper_results)
+    {
+        result.nodes += helper_result.nodes;
+        result.thread_nodes.push_back(helper_result.nodes);
+    }
+    return result;
+}
+
+ostream& operator<<(ostream& os, const SearchResult& result)
+{
+    os << "depth " << result.depth << " score " << result.score << " move " << result.best_move
+       << " nodes " << result.nodes << " nps "
+       << static_cast<uint64_t>(result.seconds > 0 ? result.nodes / result.seconds : 0);
+    if (result.thread_nodes.size() > 1)
+    {
+        os << " (per thread:";
+        for (uint64_t nodes : result.thread_nodes)
+        {
+            os << ' ' << static_cast<uint64_t>(result.seconds > 0 ? nodes / result.seconds : 0);
+        }
+        os << ')';
+    }
+    return os;
+}
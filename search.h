@@ -0,0 +1,103 @@
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "chess_board.h"
+#include "move_picker.h"
+#include "tablebase.h"
+#include "transposition_table.h"
+
+// Scores are from the point of view of the team whose turn it is, in
+// hundredths of a pawn. Capturing the enemy king is worth WIN_SCORE minus
+// the number of moves it takes, so quicker wins score higher.
+const int WIN_SCORE = 1000000;
+const int INFINITE_SCORE = WIN_SCORE + 1;
+const int MAX_SEARCH_DEPTH = 64;
+
+// When a search has to stop. A search always finishes depth 1.
+struct SearchLimits
+{
+    int milliseconds = 1000; // wall-clock budget per move, 0 for no limit
+    uint64_t nodes = 0;      // node budget per move and thread, 0 for no limit
+    int depth = MAX_SEARCH_DEPTH;
+    // Whether to keep searching captures past depth (see Search::quiescence).
+    bool quiescence = true;
+    // Endgame tablebases to look positions up in instead of searching them,
+    // or nullptr. They must outlive the search.
+    const Tablebases* tablebases = nullptr;
+};
+
+struct SearchResult
+{
+    Move best_move{};
+    int score = 0;
+    int depth = 0; // the deepest search that finished
+    uint64_t nodes = 0; // added up over all threads
+    double seconds = 0;
+    // How many nodes each thread searched (thread 0 is the main thread).
+    std::vector<uint64_t> thread_nodes{};
+};
+
+// Prints the depth, score, move and nodes per second (in total and per thread).
+std::ostream& operator<<(std::ostream& os, const SearchResult& result);
+
+// Negamax alpha-beta search with iterative deepening. It searches depth 1, then
+// depth 2 and so on until it runs out of time, nodes or depth, and returns
+// the best move of the deepest search. It walks the tree with make_move and
+// unmake_move on a single Board, and remembers results in a
+// TranspositionTable that can be shared with other searches.
+class Search
+{
+public:
+    // The search also stops as soon as stop (if not nullptr) becomes true.
+    // thread_index is 0 for a single-threaded search, and helper threads of a
+    // parallel_search use it to search a little differently from each other.
+    Search(TranspositionTable& table, SearchLimits limits,
+           const std::atomic<bool>* stop = nullptr, int thread_index = 0);
+
+    // Picks one of root_moves (the moves board.get_moves() returned).
+    SearchResult run(const Board& board, const MoveList& root_moves);
+
+private:
+    int negamax(Board& board, int depth, int ply, int alpha, int beta);
+    // Searches only captures (from Board::get_captures), until the position
+    // is quiet, so a capture just past the search depth isn't missed. Either
+    // side can "stand pat" on the evaluation instead of capturing.
+    int quiescence(Board& board, int ply, int alpha, int beta);
+    // Returns the score of searching root_moves to depth, and sets best_move.
+    // Returns false if the search was stopped before the first move finished.
+    bool search_root(Board& board, MoveList& root_moves, int depth, Move& best_move, int& best_score);
+    // Checks the time and node budgets every so often.
+    bool out_of_budget();
+
+    TranspositionTable& table;
+    // Killer moves and history scores for ordering moves, which are only
+    // worth keeping for one search.
+    MoveHistory history;
+    SearchLimits limits;
+    const std::atomic<bool>* stop_signal;
+    int thread_index;
+    std::chrono::steady_clock::time_point start;
+    uint64_t nodes = 0;
+    int root_depth = 0;
+    bool stopped = false;
+};
+
+// Lazy SMP: searches the same position on num_threads threads at once. The
+// threads share table, so each one skips the parts of the tree the others
+// have already searched, and the odd numbered helpers search one move deeper
+// to spread out the work. Returns the main thread's result once its limits run
+// out or stop becomes true, and then stops the helpers.
+//
+// With one thread this is exactly Search::run, so results are repeatable
+// (given the same table contents and a node or depth limit).
+SearchResult parallel_search(TranspositionTable& table, SearchLimits limits, int num_threads,
+                             const Board& board, const MoveList& root_moves,
+                             const std::atomic<bool>& stop);
+
+#endif // _SEARCH_H_
@@ -0,0 +1,320 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "attack_tables.h"
+#include "bitboard.h"
+#include "sliding_attacks.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SLIDING_ATTACKS_PEXT
+#if defined(__BMI2__)
+// Built for processors that all have PEXT, so there's nothing to check.
+#define PEXT_FUNCTION inline
+#else
+// Built for any x86 processor: the PEXT code is only run if has_pext().
+#define PEXT_FUNCTION __attribute__((target("bmi2")))
+#endif
+#endif
+
+using std::vector;
+
+// Magics for each square that are known to work, found with the search in
+// SlidingAttackTables (starting from the seeds given there). They're checked
+// as the tables are built, and searched for again if one doesn't work.
+const uint64_t ROOK_MAGICS[BOARD_SQUARES] = {
+    0x1080004008801020ull, 0x0840092002C03000ull, 0x1900200010400900ull, 0x0880100008000480ull,
+    0x4200100420080200ull, 0x8100020100080400ull, 0x0200040110886200ull, 0x0200008040220411ull,
+    0x0404800084400220ull, 0x0000401000402000ull, 0x0086001081220440ull, 0x0408800800100280ull,
+    0x000A001201040820ull, 0x8848800200840080ull, 0x4001000100040200ull, 0x0442000102105084ull,
+    0x9080010020804100ull, 0x0040404000201009ull, 0x0000808010002009ull, 0x2200090021D00100ull,
+    0x0008008008040080ull, 0x0004004002010040ull, 0x0011040008015042ull, 0x00000A0001768104ull,
+    0x0000800080204009ull, 0x2010004140002001ull, 0x9800200280100080ull, 0x1000100080080080ull,
+    0x0442000A00049020ull, 0x2100040080020080ull, 0x0800120400900148ull, 0x0010040A00128541ull,
+    0x2800804000800030ull, 0x1010002000400041ull, 0x4000200011004100ull, 0x0610008410800800ull,
+    0x0400802402800800ull, 0xC100020080800400ull, 0x0002000802000401ull, 0x0182085882000401ull,
+    0x0220204000808000ull, 0x2860100040024022ull, 0x0001002004110040ull, 0x99101042000A0020ull,
+    0x0004080004008080ull, 0x0010040002008080ull, 0x2012004881020004ull, 0x8300842444820011ull,
+    0x0088403882010200ull, 0x0820400080210100ull, 0x0110910040A00300ull, 0x0801100280080480ull,
+    0x0242009008200600ull, 0x1002000489500200ull, 0x0040800200010080ull, 0x0091800041000080ull,
+    0x0000209300488001ull, 0x04C1002414824001ull, 0x020020000B001041ull, 0x7000100004200901ull,
+    0x8002002004100802ull, 0x30010002084C0007ull, 0x0888221800813004ull, 0x4000002840840112ull,
+};
+
+const uint64_t BISHOP_MAGICS[BOARD_SQUARES] = {
+    0x2048017020910100ull, 0x0044410424008008ull, 0x040828A400900000ull, 0x8002209200022000ull,
+    0x0002021000540002ull, 0x0021018840000000ull, 0x00009E8420204002ull, 0x00A0920110084480ull,
+    0x4003062018010110ull, 0x0221046812004E09ull, 0x01E11002958912A0ull, 0x0000044410804000ull,
+    0x0000821210000080ull, 0x080201102210A800ull, 0x0080040411045004ull, 0x00704A1842021000ull,
+    0x1005061070322800ull, 0x0018001010410444ull, 0x0010000800401420ull, 0x2204002844000800ull,
+    0x2052020412022280ull, 0x000A020101008208ull, 0x0040400201042000ull, 0x03E1082040480410ull,
+    0x1004200004208414ull, 0x08700400984808C8ull, 0x0088080004004410ull, 0x008C0240140100A2ull,
+    0x0008840001822000ull, 0x0050088001080100ull, 0x98140840040A2200ull, 0x3002020900210110ull,
+    0x1004040640206000ull, 0x1090909000840400ull, 0x9002444810100020ull, 0x4000020080080080ull,
+    0x0028020400011010ull, 0x0290808300020100ull, 0x8010020882004410ull, 0x0604010040082C20ull,
+    0x20040104C0801008ull, 0x6004208424001050ull, 0x1002840041000800ull, 0x0200042018000102ull,
+    0xA8002000A0821C00ull, 0x0040080802201910ull, 0x0222620444000100ull, 0x0002080041020088ull,
+    0x1500820110401050ull, 0x0000492090100080ull, 0x0900410041100000ull, 0x0302000420880000ull,
+    0x0010501202020020ull, 0x0008200490049040ull, 0x0462080214A40120ull, 0x2421310102008100ull,
+    0x2400420080884060ull, 0x0800804406184208ull, 0x0B0080124A084400ull, 0x082E082300840412ull,
+    0x6051049040082200ull, 0xC610211002102101ull, 0x0000048808010433ull, 0x0010200804405440ull,
+};
+
+// Walks from square in each direction until it reaches the edge of the board
+// or an occupied cell. With skip_edges it leaves out the last cell before the
+// edge, whatever is on it.
+static Bitboard walk_rays(int square, Bitboard occupied, const Jump (&directions)[4], bool skip_edges = false)
+{
+    Bitboard attacks = 0;
+    for (Jump direction : directions)
+    {
+        int x = square % 8 + direction.x, y = square / 8 + direction.y;
+        while (x >= 0 && x < 8 && y >= 0 && y < 8)
+        {
+            bool at_edge = x + direction.x < 0 || x + direction.x >= 8 || y + direction.y < 0 || y + direction.y >= 8;
+            if (skip_edges && at_edge)
+            {
+                break;
+            }
+            Bitboard bit = square_bit(y * 8 + x);
+            attacks |= bit;
+            if (occupied & bit)
+            {
+                break;
+            }
+            x += direction.x;
+            y += direction.y;
+        }
+    }
+    return attacks;
+}
+
+// The attacks of one kind of sliding piece from every square, for every way
+// the cells on its lines can be occupied.
+//
+// Only the occupied cells in a square's mask matter: the ones on its lines,
+// but not on the edge of the board (the piece reaches an edge cell whether or
+// not it's occupied). Each square gets a table with one entry for each subset
+// of its mask. PEXT packs the mask's bits of the occupancy into an index
+// directly. Magic multiplies them by a number, found by trial and error, that
+// moves them into the top bits of the product without two different sets of
+// attacks landing on the same index.
+class SlidingAttackTables
+{
+public:
+    // Tries known_magics first. Any that don't work are replaced by searching
+    // with random numbers from seed.
+    SlidingAttackTables(const Jump (&directions)[4], const uint64_t (&known_magics)[BOARD_SQUARES], uint64_t seed);
+
+    Bitboard magic_attacks(int square, Bitboard occupied) const
+    {
+        const SquareEntry& entry = squares[square];
+        return entry.magic_attacks[((occupied & entry.mask) * entry.magic) >> entry.shift];
+    }
+
+#ifdef SLIDING_ATTACKS_PEXT
+    PEXT_FUNCTION Bitboard pext_attacks(int square, Bitboard occupied) const
+    {
+        const SquareEntry& entry = squares[square];
+        return entry.pext_attacks[_pext_u64(occupied, entry.mask)];
+    }
+#endif
+
+private:
+    struct SquareEntry
+    {
+        Bitboard mask;
+        uint64_t magic;
+        unsigned shift;
+        const Bitboard* magic_attacks;
+        const Bitboard* pext_attacks;
+    };
+
+#ifdef SLIDING_ATTACKS_PEXT
+    PEXT_FUNCTION void fill_pext_table(int square, const vector<Bitboard>& occupancies, const vector<Bitboard>& attacks, Bitboard* table) const
+    {
+        for (size_t i = 0; i < occupancies.size(); ++i)
+        {
+            table[_pext_u64(occupancies[i], squares[square].mask)] = attacks[i];
+        }
+    }
+#endif
+
+    SquareEntry squares[BOARD_SQUARES];
+    vector<Bitboard> magic_table;
+    vector<Bitboard> pext_table;
+};
+
+// xorshift64*: the random numbers we try as magics. The same seed finds the
+// same magics every time.
+static uint64_t next_random(uint64_t& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+SlidingAttackTables::SlidingAttackTables(const Jump (&directions)[4], const uint64_t (&known_magics)[BOARD_SQUARES], uint64_t seed)
+    : magic_table(), pext_table()
+{
+    size_t table_size = 0;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        squares[square].mask = walk_rays(square, 0, directions, true);
+        table_size += size_t(1) << count_squares(squares[square].mask);
+    }
+    magic_table.assign(table_size, 0);
+    if (has_pext())
+    {
+        pext_table.assign(table_size, 0);
+    }
+
+    uint64_t random_state = seed;
+    size_t offset = 0;
+    vector<Bitboard> occupancies, attacks;
+    vector<int> filled_by_try;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        SquareEntry& entry = squares[square];
+        int bits = count_squares(entry.mask);
+        size_t size = size_t(1) << bits;
+        entry.shift = static_cast<unsigned>(64 - bits);
+        entry.magic_attacks = &magic_table[offset];
+        entry.pext_attacks = pext_table.empty() ? nullptr : &pext_table[offset];
+
+        // Every subset of the mask, using the "carry rippler" trick.
+        occupancies.clear();
+        attacks.clear();
+        Bitboard occupied = 0;
+        do
+        {
+            occupancies.push_back(occupied);
+            attacks.push_back(walk_rays(square, occupied, directions));
+            occupied = (occupied - entry.mask) & entry.mask;
+        } while (occupied);
+
+        // Try the known magic, and then sparse random numbers (they make the
+        // best magics) until one works. filled_by_try says which try last
+        // wrote each entry, so the table doesn't need clearing between tries.
+        Bitboard* table = &magic_table[offset];
+        filled_by_try.assign(size, 0);
+        for (int attempt = 1;; ++attempt)
+        {
+            if (attempt == 1)
+            {
+                entry.magic = known_magics[square];
+            }
+            else
+            {
+                entry.magic = next_random(random_state) & next_random(random_state) & next_random(random_state);
+                if (count_squares((entry.mask * entry.magic) >> 56) < 6)
+                {
+                    continue;
+                }
+            }
+            bool collided = false;
+            for (size_t i = 0; i < occupancies.size() && !collided; ++i)
+            {
+                size_t index = (occupancies[i] * entry.magic) >> entry.shift;
+                if (filled_by_try[index] != attempt)
+                {
+                    filled_by_try[index] = attempt;
+                    table[index] = attacks[i];
+                }
+                else
+                {
+                    collided = table[index] != attacks[i];
+                }
+            }
+            if (!collided)
+            {
+                break;
+            }
+        }
+
+#ifdef SLIDING_ATTACKS_PEXT
+        if (entry.pext_attacks)
+        {
+            fill_pext_table(square, occupancies, attacks, &pext_table[offset]);
+        }
+#endif
+        offset += size;
+    }
+}
+
+bool has_pext()
+{
+#if defined(SLIDING_ATTACKS_PEXT) && defined(__BMI2__)
+    return true;
+#elif defined(SLIDING_ATTACKS_PEXT)
+    // This can run before main (while the tables are built), when GCC needs
+    // to be told to look at the processor first.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+
+static const SlidingAttackTables ROOK_TABLES(ROOK_DIRECTIONS, ROOK_MAGICS, 0x9E3779B97F4A7C15ull);
+static const SlidingAttackTables BISHOP_TABLES(BISHOP_DIRECTIONS, BISHOP_MAGICS, 0xD1B54A32D192ED03ull);
+static const bool USE_PEXT = has_pext();
+
+SlidingAttackMethod sliding_attack_method()
+{
+    return USE_PEXT ? PEXT : MAGIC;
+}
+
+Bitboard rook_attacks(int square, Bitboard occupied)
+{
+#ifdef SLIDING_ATTACKS_PEXT
+    if (USE_PEXT)
+    {
+        return ROOK_TABLES.pext_attacks(square, occupied);
+    }
+#endif
+    return ROOK_TABLES.magic_attacks(square, occupied);
+}
+
+Bitboard bishop_attacks(int square, Bitboard occupied)
+{
+#ifdef SLIDING_ATTACKS_PEXT
+    if (USE_PEXT)
+    {
+        return BISHOP_TABLES.pext_attacks(square, occupied);
+    }
+#endif
+    return BISHOP_TABLES.magic_attacks(square, occupied);
+}
+
+Bitboard rook_attacks(int square, Bitboard occupied, SlidingAttackMethod method)
+{
+    switch (method)
+    {
+    case RAY_WALK:
+        return walk_rays(square, occupied, ROOK_DIRECTIONS);
+#ifdef SLIDING_ATTACKS_PEXT
+    case PEXT:
+        return ROOK_TABLES.pext_attacks(square, occupied);
+#endif
+    default:
+        return ROOK_TABLES.magic_attacks(square, occupied);
+    }
+}
+
+Bitboard bishop_attacks(int square, Bitboard occupied, SlidingAttackMethod method)
+{
+    switch (method)
+    {
+    case RAY_WALK:
+        return walk_rays(square, occupied, BISHOP_DIRECTIONS);
+#ifdef SLIDING_ATTACKS_PEXT
+    case PEXT:
+        return BISHOP_TABLES.pext_attacks(square, occupied);
+#endif
+    default:
+        return BISHOP_TABLES.magic_attacks(square, occupied);
+    }
+}
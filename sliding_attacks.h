@@ -0,0 +1,40 @@
+#ifndef _SLIDING_ATTACKS_H_
+#define _SLIDING_ATTACKS_H_
+
+#include "bitboard.h"
+
+// The cells a rook or bishop on square can reach when the cells in occupied
+// have pieces on them: every cell along each line up to and including the
+// first occupied one. (Whether that piece can be captured is up to the caller.)
+//
+// The answers come from tables indexed by the occupied cells on the piece's
+// lines, which are found with a PEXT instruction on processors that have it
+// (BMI2) and with a "magic" multiply and shift everywhere else.
+Bitboard rook_attacks(int square, Bitboard occupied);
+Bitboard bishop_attacks(int square, Bitboard occupied);
+
+inline Bitboard queen_attacks(int square, Bitboard occupied)
+{
+    return rook_attacks(square, occupied) | bishop_attacks(square, occupied);
+}
+
+// Ways of finding the same attacks, for benchmarks and tests.
+enum SlidingAttackMethod
+{
+    RAY_WALK, // one cell at a time, with no tables
+    MAGIC,
+    PEXT
+};
+
+// Whether this processor has PEXT (and this program was built with it).
+bool has_pext();
+
+// The method rook_attacks and bishop_attacks use: PEXT if has_pext(), or else MAGIC.
+SlidingAttackMethod sliding_attack_method();
+
+// rook_attacks and bishop_attacks with the given method. PEXT must only be
+// used if has_pext().
+Bitboard rook_attacks(int square, Bitboard occupied, SlidingAttackMethod method);
+Bitboard bishop_attacks(int square, Bitboard occupied, SlidingAttackMethod method);
+
+#endif // _SLIDING_ATTACKS_H_
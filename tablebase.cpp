@@ -0,0 +1,1096 @@
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "attack_tables.h"
+#include "bitboard.h"
+#include "chess_board.h"
+#include "chess_pieces.h"
+#include "sliding_attacks.h"
+#include "tablebase.h"
+
+using std::atomic;
+using std::invalid_argument;
+using std::runtime_error;
+using std::string;
+using std::thread;
+using std::vector;
+
+// The letters for the piece types in material names, indexed by PieceType.
+const char PIECE_LETTERS[] = ".KQBNRPDM";
+
+// Values that only exist while a table is being generated: positions not
+// decided yet, and ones an even sweep has yet to check for a loss.
+const uint8_t UNDECIDED = 255;
+const uint8_t CANDIDATE = 254;
+// The longest win or loss a table can store.
+const int MAX_DISTANCE = 253;
+
+// How many positions a generator thread takes at a time.
+const size_t SWEEP_CHUNK = 4096;
+
+// Pieces sort in a table's order by this, and then by square: white's
+// pieces before black's, and each team's by type (so the king comes first).
+static int piece_order(PieceCode code)
+{
+    return (code_team(code) == WHITE ? 0 : NUM_PIECE_TYPES) + code_type(code);
+}
+
+static bool piece_before(const TablebasePosition& position, int a, int b)
+{
+    int order_a = piece_order(position.codes[a]), order_b = piece_order(position.codes[b]);
+    return order_a != order_b ? order_a < order_b : position.squares[a] < position.squares[b];
+}
+
+static void sort_pieces(TablebasePosition& position)
+{
+    // There are only a few, so an insertion sort does.
+    for (int i = 1; i < position.count; ++i)
+    {
+        for (int j = i; j > 0 && piece_before(position, j, j - 1); --j)
+        {
+            std::swap(position.codes[j], position.codes[j - 1]);
+            std::swap(position.squares[j], position.squares[j - 1]);
+        }
+    }
+}
+
+static int count_white(const TablebasePosition& position)
+{
+    int white = 0;
+    while (white < position.count && code_team(position.codes[white]) == WHITE)
+    {
+        ++white;
+    }
+    return white;
+}
+
+// Whether the tables keep a material this way round: white has more pieces
+// than black, or as many and the strongest first. The pieces must be sorted.
+static bool white_is_stronger(const TablebasePosition& position)
+{
+    int white = count_white(position), black = position.count - white;
+    if (white != black)
+    {
+        return white > black;
+    }
+    for (int i = 1; i < white; ++i)
+    {
+        PieceType white_type = code_type(position.codes[i]), black_type = code_type(position.codes[white + i]);
+        if (white_type != black_type)
+        {
+            return white_type < black_type;
+        }
+    }
+    return true;
+}
+
+// Swaps the teams and turns the board upside down (y to 7 - y).
+static void swap_teams(TablebasePosition& position)
+{
+    for (int i = 0; i < position.count; ++i)
+    {
+        Team team = code_team(position.codes[i]) == WHITE ? BLACK : WHITE;
+        position.codes[i] = make_piece_code(code_type(position.codes[i]), team);
+        position.squares[i] ^= 56;
+    }
+    position.turn = position.turn == WHITE ? BLACK : WHITE;
+}
+
+// Puts position in the form the tables store it in (see the top of
+// tablebase.h). Returns false if it can't be in a table: too few or too many
+// pieces, custom pieces, or not one king on each team.
+static bool canonicalize(TablebasePosition& position)
+{
+    if (position.count < 2 || position.count > MAX_TABLEBASE_PIECES)
+    {
+        return false;
+    }
+    int kings = 0;
+    for (int i = 0; i < position.count; ++i)
+    {
+        PieceType type = code_type(position.codes[i]);
+        if (type == NO_PIECE || type == CUSTOM_PIECE)
+        {
+            return false;
+        }
+        kings += type == KING;
+    }
+    sort_pieces(position);
+    int white = count_white(position);
+    if (kings != 2 || white == position.count || position.codes[0] != make_piece_code(KING, WHITE) ||
+        position.codes[white] != make_piece_code(KING, BLACK))
+    {
+        return false;
+    }
+    if (!white_is_stronger(position))
+    {
+        swap_teams(position);
+        sort_pieces(position);
+    }
+    if (position.squares[0] % 8 >= 4)
+    {
+        // Mirrors the board left to right (x to 7 - x).
+        for (int i = 0; i < position.count; ++i)
+        {
+            position.squares[i] ^= 7;
+        }
+        sort_pieces(position);
+    }
+    return true;
+}
+
+// Tells the tables apart: the PieceCodes (which fit in 6 bits) in the
+// table's order.
+static uint32_t material_key(const PieceCode* codes, int count)
+{
+    uint32_t key = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        key = key << 6 | codes[i];
+    }
+    return key;
+}
+
+// Whether the kings of position (in the table's order) are next to each
+// other. The team to move then wins by capturing, so tables leave those
+// positions out.
+static bool kings_touch(const TablebasePosition& position)
+{
+    return (KING_ATTACKS[position.squares[0]] & square_bit(position.squares[count_white(position)])) != 0;
+}
+
+// The cells the kings can be on in a table: white's on files a to d and
+// black's anywhere but on or next to it. There are 1806 such pairs,
+// numbered in the order of white's cell and then black's.
+struct KingPairs
+{
+    int count = 0;
+    int index[BOARD_SQUARES][BOARD_SQUARES] = {};
+    int white[BOARD_SQUARES * BOARD_SQUARES / 2] = {};
+    int black[BOARD_SQUARES * BOARD_SQUARES / 2] = {};
+};
+
+static const KingPairs& king_pairs()
+{
+    static const KingPairs pairs = [] {
+        KingPairs pairs;
+        for (int white = 0; white < BOARD_SQUARES; ++white)
+        {
+            for (int black = 0; black < BOARD_SQUARES; ++black)
+            {
+                if (white % 8 < 4 && black != white && !(KING_ATTACKS[white] & square_bit(black)))
+                {
+                    pairs.index[white][black] = pairs.count;
+                    pairs.white[pairs.count] = white;
+                    pairs.black[pairs.count] = black;
+                    ++pairs.count;
+                }
+            }
+        }
+        return pairs;
+    }();
+    return pairs;
+}
+
+// The number of ways to put k pieces of one kind on n free cells.
+static size_t binomial(int n, int k)
+{
+    struct Triangle
+    {
+        size_t rows[BOARD_SQUARES + 1][MAX_TABLEBASE_PIECES - 1];
+    };
+    static const Triangle triangle = [] {
+        Triangle pascal = {};
+        for (int row = 0; row <= BOARD_SQUARES; ++row)
+        {
+            pascal.rows[row][0] = 1;
+            for (int column = 1; row > 0 && column < MAX_TABLEBASE_PIECES - 1; ++column)
+            {
+                pascal.rows[row][column] = pascal.rows[row - 1][column - 1] + pascal.rows[row - 1][column];
+            }
+        }
+        return pascal;
+    }();
+    return triangle.rows[n][k];
+}
+
+// Pieces of one kind are next to each other in the table's order. Returns
+// the end of the run of them that starts at first.
+static int run_end(const PieceCode* codes, int count, int first)
+{
+    int end = first + 1;
+    while (end < count && codes[end] == codes[first])
+    {
+        ++end;
+    }
+    return end;
+}
+
+// Both teams to move, each pair of kings, and then for each run of pieces of
+// one kind each set of cells they can be on among the ones still free.
+static size_t table_size(const PieceCode* codes, int count)
+{
+    size_t size = 2 * static_cast<size_t>(king_pairs().count);
+    int placed = 2;
+    for (int first = 1; first < count;)
+    {
+        if (code_type(codes[first]) == KING)
+        {
+            ++first;
+            continue;
+        }
+        int end = run_end(codes, count, first);
+        size *= binomial(BOARD_SQUARES - placed, end - first);
+        placed += end - first;
+        first = end;
+    }
+    return size;
+}
+
+// The number of position (canonicalized, with the kings apart) in its table,
+// counting in the order table_size lists the choices (the last one changes
+// fastest). A run of pieces on free cells number r0 < r1 < ... (counting
+// only the free ones) is set number binomial(r0, 1) + binomial(r1, 2) + ...
+static size_t position_index(const TablebasePosition& position)
+{
+    const KingPairs& pairs = king_pairs();
+    int white_king = position.squares[0], black_king = position.squares[count_white(position)];
+    size_t index = (position.turn == WHITE ? 0 : static_cast<size_t>(pairs.count)) +
+                   static_cast<size_t>(pairs.index[white_king][black_king]);
+    Bitboard occupied = square_bit(white_king) | square_bit(black_king);
+    for (int first = 1; first < position.count;)
+    {
+        if (code_type(position.codes[first]) == KING)
+        {
+            ++first;
+            continue;
+        }
+        int end = run_end(position.codes, position.count, first);
+        size_t set = 0;
+        for (int i = first; i < end; ++i)
+        {
+            int square = position.squares[i];
+            set += binomial(square - count_squares(occupied & (square_bit(square) - 1)), i - first + 1);
+        }
+        index = index * binomial(BOARD_SQUARES - count_squares(occupied), end - first) + set;
+        for (int i = first; i < end; ++i)
+        {
+            occupied |= square_bit(position.squares[i]);
+        }
+        first = end;
+    }
+    return index;
+}
+
+// The free cell number rank, counting only the ones not in occupied.
+static int free_square(Bitboard occupied, int rank)
+{
+    Bitboard free = ~occupied;
+    for (int i = 0; i < rank; ++i)
+    {
+        free &= free - 1;
+    }
+    return lowest_square(free);
+}
+
+// Sets position to the one at index in the table for codes (the other way
+// round from position_index).
+static void index_position(const vector<PieceCode>& codes, size_t index, TablebasePosition& position)
+{
+    position.count = static_cast<int>(codes.size());
+    std::copy(codes.begin(), codes.end(), position.codes);
+
+    // The runs' sets come off the end of index first, but which cells are
+    // free for each run depends on the runs before it.
+    int firsts[MAX_TABLEBASE_PIECES], ends[MAX_TABLEBASE_PIECES];
+    size_t sets[MAX_TABLEBASE_PIECES];
+    int runs = 0;
+    for (int first = 1; first < position.count;)
+    {
+        if (code_type(position.codes[first]) == KING)
+        {
+            ++first;
+            continue;
+        }
+        firsts[runs] = first;
+        ends[runs] = first = run_end(position.codes, position.count, first);
+        ++runs;
+    }
+    int placed = position.count;
+    for (int run = runs - 1; run >= 0; --run)
+    {
+        placed -= ends[run] - firsts[run];
+        size_t run_sets = binomial(BOARD_SQUARES - placed, ends[run] - firsts[run]);
+        sets[run] = index % run_sets;
+        index /= run_sets;
+    }
+
+    const KingPairs& pairs = king_pairs();
+    size_t pair = index % static_cast<size_t>(pairs.count);
+    position.turn = index / static_cast<size_t>(pairs.count) == 0 ? WHITE : BLACK;
+    position.squares[0] = pairs.white[pair];
+    position.squares[count_white(position)] = pairs.black[pair];
+    Bitboard occupied = square_bit(position.squares[0]) | square_bit(position.squares[count_white(position)]);
+    for (int run = 0; run < runs; ++run)
+    {
+        // The biggest rank whose binomial still fits in what's left of the
+        // set, for the last piece of the run first.
+        Bitboard run_squares = 0;
+        for (int i = ends[run] - 1; i >= firsts[run]; --i)
+        {
+            int k = i - firsts[run] + 1, rank = k - 1;
+            while (binomial(rank + 1, k) <= sets[run])
+            {
+                ++rank;
+            }
+            sets[run] -= binomial(rank, k);
+            position.squares[i] = free_square(occupied, rank);
+            run_squares |= square_bit(position.squares[i]);
+        }
+        occupied |= run_squares;
+    }
+}
+
+// How many bytes the packed values of a table with size positions take, with
+// a byte to spare so a value can always be read as two bytes.
+static size_t packed_size(size_t size, int bits)
+{
+    return size * static_cast<size_t>(bits) / 8 + 2;
+}
+
+// The value of position index, packed bits to a position (see the top of
+// tablebase.h).
+static uint8_t packed_value(const uint8_t* values, const uint8_t* packed, int bits, size_t index)
+{
+    size_t bit = index * static_cast<size_t>(bits);
+    unsigned two_bytes = packed[bit / 8] | static_cast<unsigned>(packed[bit / 8 + 1]) << 8;
+    return values[two_bytes >> (bit % 8) & ((1u << bits) - 1)];
+}
+
+static TablebaseResult value_result(uint8_t value)
+{
+    TablebaseResult result;
+    if (value != 0)
+    {
+        result.outcome = value % 2 == 1 ? TABLEBASE_WIN : TABLEBASE_LOSS;
+        result.plies = value;
+    }
+    return result;
+}
+
+// The built in piece with code.
+static const ChessPiece& code_piece(PieceCode code)
+{
+    static const vector<const ChessPiece*> pieces = [] {
+        vector<const ChessPiece*> by_code(64, &EMPTY_SPACE);
+        for (const auto& codepoint_piece : ALL_CHESS_PIECES)
+        {
+            by_code[codepoint_piece.second->code] = codepoint_piece.second;
+        }
+        return by_code;
+    }();
+    return *pieces[code];
+}
+
+static string material_name(const vector<PieceCode>& codes)
+{
+    string name;
+    for (PieceCode code : codes)
+    {
+        if (code == make_piece_code(KING, BLACK))
+        {
+            name += 'v';
+        }
+        name += PIECE_LETTERS[code_type(code)];
+    }
+    return name;
+}
+
+// The pieces of material ("KQvK") in the table's order. Throws
+// invalid_argument if it isn't a material a table can have.
+static vector<PieceCode> parse_material(const string& material)
+{
+    size_t v = material.find('v');
+    TablebasePosition position;
+    for (size_t i = 0; i < material.size(); ++i)
+    {
+        if (i == v)
+        {
+            continue;
+        }
+        const char* letter = std::strchr(PIECE_LETTERS + 1, material[i]);
+        if (!letter || *letter == '\0' || position.count == MAX_TABLEBASE_PIECES)
+        {
+            throw invalid_argument("Not a tablebase material: " + material);
+        }
+        PieceType type = static_cast<PieceType>(letter - PIECE_LETTERS);
+        position.codes[position.count] = make_piece_code(type, i < v ? WHITE : BLACK);
+        position.squares[position.count] = position.count;
+        ++position.count;
+    }
+    if (v == string::npos || !canonicalize(position))
+    {
+        throw invalid_argument("Not a tablebase material: " + material);
+    }
+    return vector<PieceCode>(position.codes, position.codes + position.count);
+}
+
+Tablebases::Tablebases(const string& directory)
+    : tables()
+{
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir)
+    {
+        throw runtime_error("Can't read tablebase directory " + directory);
+    }
+    vector<string> names;
+    while (const dirent* entry = ::readdir(dir))
+    {
+        string name = entry->d_name;
+        size_t extension = std::strlen(TABLEBASE_EXTENSION);
+        if (name.size() > extension && name.compare(name.size() - extension, extension, TABLEBASE_EXTENSION) == 0)
+        {
+            names.push_back(name);
+        }
+    }
+    ::closedir(dir);
+
+    for (const string& name : names)
+    {
+        string path = directory + "/" + name;
+        Table table;
+        table.file = MappedFile(path);
+        const uint8_t* header = reinterpret_cast<const uint8_t*>(table.file.data());
+        int count = table.file.size() > TABLEBASE_HEADER_SIZE ? header[8] : 0;
+        bool valid = count >= 2 && count <= MAX_TABLEBASE_PIECES &&
+            std::memcmp(header, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC)) == 0;
+        TablebasePosition position;
+        if (valid)
+        {
+            // The pieces have to be in the order the table is looked up in.
+            position.count = count;
+            for (int i = 0; i < count; ++i)
+            {
+                position.codes[i] = header[9 + i];
+                position.squares[i] = i;
+            }
+            valid = canonicalize(position) && std::memcmp(position.codes, header + 9, static_cast<size_t>(count)) == 0;
+        }
+        if (valid)
+        {
+            table.bits = header[14];
+            size_t num_values = header[15];
+            valid = table.bits <= 8 && num_values >= 1 && num_values <= size_t(1) << table.bits &&
+                table.file.size() == TABLEBASE_HEADER_SIZE + num_values + packed_size(table_size(position.codes, count), table.bits);
+            table.values = header + TABLEBASE_HEADER_SIZE;
+            table.packed = table.values + num_values;
+            for (size_t i = 0; valid && i < num_values; ++i)
+            {
+                valid = table.values[i] <= MAX_DISTANCE;
+            }
+        }
+        if (!valid)
+        {
+            throw runtime_error(path + " isn't a tablebase");
+        }
+        most_pieces = std::max(most_pieces, count);
+        tables.emplace(material_key(position.codes, count), std::move(table));
+    }
+}
+
+bool Tablebases::probe(const Board& board, TablebaseResult& result) const
+{
+    Bitboard occupied = board.occupancy();
+    if (count_squares(occupied) > most_pieces)
+    {
+        return false;
+    }
+    TablebasePosition position;
+    while (occupied)
+    {
+        int square = pop_lowest_square(occupied);
+        position.codes[position.count] = board.code(square);
+        position.squares[position.count++] = square;
+    }
+    position.turn = board.turn();
+    if (!canonicalize(position))
+    {
+        return false;
+    }
+    auto table = tables.find(material_key(position.codes, position.count));
+    if (table == tables.end())
+    {
+        return false;
+    }
+    if (kings_touch(position))
+    {
+        result = value_result(1);
+        return true;
+    }
+    const Table& found = table->second;
+    result = value_result(packed_value(found.values, found.packed, found.bits, position_index(position)));
+    return true;
+}
+
+// Higher is better for the team the result is for: quicker wins, then
+// draws, then slower losses.
+static int result_rank(TablebaseResult result)
+{
+    switch (result.outcome)
+    {
+    case TABLEBASE_WIN:
+        return 1000 - result.plies;
+    case TABLEBASE_LOSS:
+        return result.plies - 1000;
+    default:
+        return 0;
+    }
+}
+
+bool Tablebases::best_move(const Board& board, const MoveList& moves, Move& move, TablebaseResult& result) const
+{
+    if (moves.captures_king())
+    {
+        move = moves.king_capture();
+        result.outcome = TABLEBASE_WIN;
+        result.plies = 1;
+        return true;
+    }
+    Board after = board;
+    bool found = false;
+    for (Move candidate : moves)
+    {
+        UndoRecord undo = after.make_move(candidate);
+        TablebaseResult reply;
+        bool in_table = probe(after, reply);
+        after.unmake_move(undo);
+        if (!in_table)
+        {
+            return false;
+        }
+        // reply is for the other team.
+        TablebaseResult candidate_result;
+        if (reply.outcome != TABLEBASE_DRAW)
+        {
+            candidate_result.outcome = reply.outcome == TABLEBASE_WIN ? TABLEBASE_LOSS : TABLEBASE_WIN;
+            candidate_result.plies = reply.plies + 1;
+        }
+        if (!found || result_rank(candidate_result) > result_rank(result))
+        {
+            found = true;
+            move = candidate;
+            result = candidate_result;
+        }
+    }
+    return found;
+}
+
+// Runs work on threads threads at once, this one included.
+template <class Work>
+static void run_on_threads(int threads, const Work& work)
+{
+    vector<thread> helpers;
+    for (int i = 1; i < threads; ++i)
+    {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (thread& helper : helpers)
+    {
+        helper.join();
+    }
+}
+
+// A board with nothing on it, for the generator to set positions up on.
+static Board empty_board()
+{
+    Board board;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        board.place_piece(to_cell(square), EMPTY_SPACE);
+    }
+    return board;
+}
+
+static void set_up(Board& board, const TablebasePosition& position)
+{
+    for (int i = 0; i < position.count; ++i)
+    {
+        board.place_piece(to_cell(position.squares[i]), code_piece(position.codes[i]));
+    }
+    board.set_turn(position.turn);
+}
+
+static void take_down(Board& board, const TablebasePosition& position)
+{
+    for (int i = 0; i < position.count; ++i)
+    {
+        board.place_piece(to_cell(position.squares[i]), EMPTY_SPACE);
+    }
+}
+
+// The empty cells (occupied has the others) the piece with code on square
+// could have just moved from, by a capture or not. rooks are the rooks of
+// both teams, for the dark knight's grapple gun. These are the moves of
+// piece_moves.h the other way round.
+static Bitboard unmove_origins(PieceCode code, int square, Bitboard occupied, Bitboard rooks, bool capture)
+{
+    int back = -forward_steps(code_team(code));
+    Bitboard origins = 0;
+    switch (code_type(code))
+    {
+    case KING:
+        origins = KING_ATTACKS[square];
+        break;
+    case QUEEN:
+        origins = queen_attacks(square, occupied);
+        break;
+    case BISHOP:
+        origins = bishop_attacks(square, occupied);
+        break;
+    case KNIGHT:
+        origins = KNIGHT_ATTACKS[square];
+        break;
+    case ROOK:
+        origins = rook_attacks(square, occupied);
+        break;
+    case PAWN:
+        origins = capture ? PAWN_ATTACKS[step_table_index(back)][square] : PAWN_PUSHES[step_table_index(back)][square];
+        break;
+    case COWARDLY_DOG:
+        // A retreat hops back from anywhere ahead on the file.
+        origins = capture ? PAWN_ATTACKS[step_table_index(back)][square]
+                          : PAWN_PUSHES[step_table_index(back)][square] | FILE_RAYS[step_table_index(-back)][square];
+        break;
+    case DARK_KNIGHT:
+        origins = (queen_attacks(square, occupied) & DARK_KNIGHT_REACH[square]) | KNIGHT_ATTACKS[square];
+        // He can have grappled to a rook next to square from anywhere on
+        // its open lines.
+        for (Bitboard near_rooks = KING_ATTACKS[square] & rooks; near_rooks;)
+        {
+            origins |= queen_attacks(pop_lowest_square(near_rooks), 0);
+        }
+        break;
+    default:
+        break;
+    }
+    return origins & ~occupied;
+}
+
+// Calls visit with every position (not canonicalized) that position is one
+// move after: the team not to move takes back a move, which captured a piece
+// with code captured unless captured is EMPTY_SPACE's.
+template <class Visit>
+static void for_each_unmove(const TablebasePosition& position, PieceCode captured, const Visit& visit)
+{
+    Team mover = position.turn == WHITE ? BLACK : WHITE;
+    bool capture = captured != EMPTY_SPACE.code;
+    Bitboard occupied = 0, rooks = 0;
+    for (int i = 0; i < position.count; ++i)
+    {
+        occupied |= square_bit(position.squares[i]);
+        rooks |= code_type(position.codes[i]) == ROOK ? square_bit(position.squares[i]) : 0;
+    }
+    for (int i = 0; i < position.count; ++i)
+    {
+        if (code_team(position.codes[i]) != mover)
+        {
+            continue;
+        }
+        Bitboard origins = unmove_origins(position.codes[i], position.squares[i], occupied, rooks, capture);
+        while (origins)
+        {
+            TablebasePosition before = position;
+            before.squares[i] = pop_lowest_square(origins);
+            before.turn = mover;
+            if (capture)
+            {
+                before.codes[before.count] = captured;
+                before.squares[before.count++] = position.squares[i];
+            }
+            visit(before);
+        }
+    }
+}
+
+// The pieces of a material, on cells 0, 1 and so on.
+static TablebasePosition material_position(const vector<PieceCode>& pieces)
+{
+    TablebasePosition position;
+    for (PieceCode code : pieces)
+    {
+        position.codes[position.count] = code;
+        position.squares[position.count] = position.count;
+        ++position.count;
+    }
+    return position;
+}
+
+// The pieces that, captured from the team to move in a position with pieces,
+// leave it there from a position of the table with key.
+static vector<PieceCode> completing_captures(const vector<PieceCode>& pieces, uint32_t key, Team team)
+{
+    vector<PieceCode> captures;
+    for (int type = QUEEN; type <= DARK_KNIGHT; ++type)
+    {
+        TablebasePosition before = material_position(pieces);
+        before.codes[before.count] = make_piece_code(static_cast<PieceType>(type), team);
+        before.squares[before.count] = before.count;
+        ++before.count;
+        if (canonicalize(before) && material_key(before.codes, before.count) == key)
+        {
+            captures.push_back(make_piece_code(static_cast<PieceType>(type), team));
+        }
+    }
+    return captures;
+}
+
+void TablebaseGenerator::generate(const string& material)
+{
+    generate(parse_material(material));
+}
+
+void TablebaseGenerator::generate(const vector<PieceCode>& pieces)
+{
+    uint32_t key = material_key(pieces.data(), static_cast<int>(pieces.size()));
+    if (tables.count(key))
+    {
+        return;
+    }
+    // Capturing any piece but a king leads into a smaller table.
+    vector<uint32_t> smaller;
+    for (size_t captured = 0; captured < pieces.size(); ++captured)
+    {
+        if (code_type(pieces[captured]) == KING)
+        {
+            continue;
+        }
+        TablebasePosition after;
+        for (size_t i = 0; i < pieces.size(); ++i)
+        {
+            if (i != captured)
+            {
+                after.codes[after.count] = pieces[i];
+                after.squares[after.count] = after.count;
+                ++after.count;
+            }
+        }
+        canonicalize(after);
+        generate(vector<PieceCode>(after.codes, after.codes + after.count));
+        uint32_t after_key = material_key(after.codes, after.count);
+        if (std::find(smaller.begin(), smaller.end(), after_key) == smaller.end())
+        {
+            smaller.push_back(after_key);
+        }
+    }
+
+    // A capture can lead to a win or loss as long as the longest in the
+    // smaller tables, so the sweeps have to get that far.
+    int longest_smaller = 0;
+    for (uint32_t smaller_key : smaller)
+    {
+        longest_smaller = std::max(longest_smaller, tables.at(smaller_key).longest);
+    }
+    Table& table = tables[key];
+    table.pieces = pieces;
+    table.size = table_size(pieces.data(), static_cast<int>(pieces.size()));
+    table.values.reset(new atomic<uint8_t>[table.size]);
+    size_t decided_before = 1;
+    for (int distance = 1;; ++distance)
+    {
+        size_t decided = distance <= 2 ? sweep(key, table, distance) : retrograde_sweep(key, table, distance, smaller);
+        if (decided == 0 && decided_before == 0 && distance > longest_smaller + 1)
+        {
+            break;
+        }
+        if (distance == MAX_DISTANCE)
+        {
+            tables.erase(key);
+            throw runtime_error(material_name(pieces) + " has wins longer than a tablebase can store");
+        }
+        decided_before = decided;
+    }
+    for (size_t index = 0; index < table.size; ++index)
+    {
+        uint8_t value = table.values[index].load(std::memory_order_relaxed);
+        if (value == UNDECIDED)
+        {
+            table.values[index].store(0, std::memory_order_relaxed);
+        }
+        else
+        {
+            table.longest = std::max(table.longest, static_cast<int>(value));
+        }
+    }
+}
+
+uint8_t TablebaseGenerator::move_value(uint32_t key, const TablebasePosition& position, Move move) const
+{
+    TablebasePosition after = position;
+    int from = to_square(move.from), to = to_square(move.to);
+    int captured = -1;
+    for (int i = 0; i < after.count; ++i)
+    {
+        if (after.squares[i] == to)
+        {
+            captured = i;
+        }
+        else if (after.squares[i] == from)
+        {
+            after.squares[i] = to;
+        }
+    }
+    if (captured >= 0)
+    {
+        for (int i = captured + 1; i < after.count; ++i)
+        {
+            after.codes[i - 1] = after.codes[i];
+            after.squares[i - 1] = after.squares[i];
+        }
+        --after.count;
+    }
+    after.turn = after.turn == WHITE ? BLACK : WHITE;
+    canonicalize(after);
+    if (kings_touch(after))
+    {
+        return 1;
+    }
+    uint32_t after_key = captured >= 0 ? material_key(after.codes, after.count) : key;
+    return tables.at(after_key).values[position_index(after)].load(std::memory_order_relaxed);
+}
+
+bool TablebaseGenerator::loses_in(uint32_t key, const TablebasePosition& position, int distance, Board& board) const
+{
+    set_up(board, position);
+    MoveList moves = board.get_moves();
+    take_down(board, position);
+    // UNDECIDED is odd too, but bigger (and CANDIDATE is even).
+    return !moves.empty() && std::all_of(moves.begin(), moves.end(), [&](Move move) {
+        uint8_t after = move_value(key, position, move);
+        return after % 2 == 1 && after < distance;
+    });
+}
+
+size_t TablebaseGenerator::sweep(uint32_t key, Table& table, int distance)
+{
+    atomic<size_t> next_chunk(0);
+    atomic<size_t> decided(0);
+    run_on_threads(threads, [&]() {
+        Board board = empty_board();
+        TablebasePosition position;
+        size_t decided_here = 0;
+        for (size_t start = next_chunk.fetch_add(SWEEP_CHUNK); start < table.size; start = next_chunk.fetch_add(SWEEP_CHUNK))
+        {
+            size_t end = std::min(start + SWEEP_CHUNK, table.size);
+            for (size_t index = start; index < end; ++index)
+            {
+                atomic<uint8_t>& value = table.values[index];
+                if (distance > 1 && value.load(std::memory_order_relaxed) != (distance == 2 ? UNDECIDED : CANDIDATE))
+                {
+                    continue;
+                }
+                index_position(table.pieces, index, position);
+                uint8_t result = UNDECIDED;
+                if (distance == 1)
+                {
+                    set_up(board, position);
+                    MoveList moves = board.get_moves();
+                    take_down(board, position);
+                    if (moves.empty())
+                    {
+                        result = 0;
+                    }
+                    else if (moves.captures_king())
+                    {
+                        result = 1;
+                    }
+                }
+                else if (loses_in(key, position, distance, board))
+                {
+                    result = static_cast<uint8_t>(distance);
+                }
+                value.store(result, std::memory_order_relaxed);
+                decided_here += result != UNDECIDED;
+            }
+        }
+        decided += decided_here;
+    });
+    return decided;
+}
+
+size_t TablebaseGenerator::retrograde_sweep(uint32_t key, Table& table, int distance, const vector<uint32_t>& smaller)
+{
+    // The positions whose value is distance - 1 in this table, and in each
+    // smaller table with the piece they captured to get there.
+    struct Source
+    {
+        const Table* table;
+        vector<PieceCode> captures[2];
+    };
+    vector<Source> sources = {{&table, {{EMPTY_SPACE.code}, {EMPTY_SPACE.code}}}};
+    for (uint32_t smaller_key : smaller)
+    {
+        const Table& after = tables.at(smaller_key);
+        sources.push_back({&after, {completing_captures(after.pieces, key, WHITE), completing_captures(after.pieces, key, BLACK)}});
+    }
+    // Tables with the same pieces on both teams (KRvKR) keep both ways round
+    // of a position, but a smaller table only has one way round of what a
+    // capture leaves, so each capture taken back stands for both.
+    TablebasePosition swapped = material_position(table.pieces);
+    swap_teams(swapped);
+    sort_pieces(swapped);
+    bool symmetric = material_key(swapped.codes, swapped.count) == key;
+
+    uint8_t previous = static_cast<uint8_t>(distance - 1);
+    // One move before a loss is a win, but one before a win is only a loss
+    // if all the other moves are wins too. sweep checks each of those once,
+    // however many of its moves lead to a win in distance - 1.
+    uint8_t found = distance % 2 == 1 ? static_cast<uint8_t>(distance) : CANDIDATE;
+    atomic<size_t> decided(0);
+    for (const Source& source : sources)
+    {
+        atomic<size_t> next_chunk(0);
+        run_on_threads(threads, [&]() {
+            TablebasePosition position;
+            size_t decided_here = 0;
+            auto mark = [&](TablebasePosition before) {
+                canonicalize(before);
+                if (kings_touch(before))
+                {
+                    return;
+                }
+                atomic<uint8_t>& value = table.values[position_index(before)];
+                uint8_t undecided = UNDECIDED;
+                if (value.load(std::memory_order_relaxed) == UNDECIDED &&
+                    value.compare_exchange_strong(undecided, found, std::memory_order_relaxed))
+                {
+                    ++decided_here;
+                }
+            };
+            for (size_t start = next_chunk.fetch_add(SWEEP_CHUNK); start < source.table->size; start = next_chunk.fetch_add(SWEEP_CHUNK))
+            {
+                size_t end = std::min(start + SWEEP_CHUNK, source.table->size);
+                for (size_t index = start; index < end; ++index)
+                {
+                    if (source.table->values[index].load(std::memory_order_relaxed) != previous)
+                    {
+                        continue;
+                    }
+                    index_position(source.table->pieces, index, position);
+                    for (PieceCode captured : source.captures[position.turn == WHITE ? 0 : 1])
+                    {
+                        for_each_unmove(position, captured, [&](TablebasePosition before) {
+                            mark(before);
+                            if (symmetric && source.table != &table)
+                            {
+                                swap_teams(before);
+                                mark(before);
+                            }
+                        });
+                    }
+                }
+            }
+            decided += decided_here;
+        });
+    }
+    return distance % 2 == 1 ? decided.load() : sweep(key, table, distance);
+}
+
+vector<string> TablebaseGenerator::materials() const
+{
+    vector<string> names;
+    for (const auto& key_table : tables)
+    {
+        names.push_back(material_name(key_table.second.pieces));
+    }
+    return names;
+}
+
+void TablebaseGenerator::write(const string& directory) const
+{
+    vector<char> buffer(1 << 20);
+    for (const auto& key_table : tables)
+    {
+        const Table& table = key_table.second;
+        string path = directory + "/" + material_name(table.pieces) + TABLEBASE_EXTENSION;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+        // The values the table has, and the bits it takes to number them.
+        bool present[MAX_DISTANCE + 1] = {};
+        for (size_t index = 0; index < table.size; ++index)
+        {
+            present[table.values[index].load(std::memory_order_relaxed)] = true;
+        }
+        vector<char> values;
+        uint8_t numbers[MAX_DISTANCE + 1] = {};
+        for (int value = 0; value <= MAX_DISTANCE; ++value)
+        {
+            if (present[value])
+            {
+                numbers[value] = static_cast<uint8_t>(values.size());
+                values.push_back(static_cast<char>(value));
+            }
+        }
+        int bits = 0;
+        while (size_t(1) << bits < values.size())
+        {
+            ++bits;
+        }
+
+        char header[TABLEBASE_HEADER_SIZE] = {};
+        std::memcpy(header, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+        header[8] = static_cast<char>(table.pieces.size());
+        for (size_t i = 0; i < table.pieces.size(); ++i)
+        {
+            header[9 + i] = static_cast<char>(table.pieces[i]);
+        }
+        header[14] = static_cast<char>(bits);
+        header[15] = static_cast<char>(values.size());
+        file.write(header, sizeof(header));
+        file.write(values.data(), static_cast<std::streamsize>(values.size()));
+
+        // Fills bytes from their lowest bit up, then pads the end out.
+        size_t filled = 0, written = 0;
+        unsigned pending = 0;
+        int pending_bits = 0;
+        for (size_t index = 0; index < table.size; ++index)
+        {
+            pending |= static_cast<unsigned>(numbers[table.values[index].load(std::memory_order_relaxed)]) << pending_bits;
+            pending_bits += bits;
+            while (pending_bits >= 8)
+            {
+                buffer[filled++] = static_cast<char>(pending & 0xff);
+                pending >>= 8;
+                pending_bits -= 8;
+                if (filled == buffer.size())
+                {
+                    file.write(buffer.data(), static_cast<std::streamsize>(filled));
+                    written += filled;
+                    filled = 0;
+                }
+            }
+        }
+        if (pending_bits > 0)
+        {
+            buffer[filled++] = static_cast<char>(pending);
+        }
+        written += filled;
+        file.write(buffer.data(), static_cast<std::streamsize>(filled));
+        vector<char> padding(packed_size(table.size, bits) - written, 0);
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.close();
+        if (!file)
+        {
+            throw runtime_error("Can't write tablebase " + path);
+        }
+    }
+}
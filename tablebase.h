@@ -0,0 +1,186 @@
+#ifndef _TABLEBASE_H_
+#define _TABLEBASE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chess_board.h"
+#include "mapped_file.h"
+
+// Endgame tablebases: the result of perfect play from every position with a
+// few pieces, worked out ahead of time.
+//
+// A table covers one material, named with a letter for each piece, white's
+// first, e.g. "KQvK" or "KRPvKR": K king, Q queen, B bishop, N knight,
+// R rook, P pawn, D cowardly dog and M dark knight. Custom pieces can't be in
+// a table. A table has a value for each position with its pieces and team to
+// move: 0 for a draw, an odd number d for a win (the team to move captures
+// the king in d plies) and an even number d for a loss.
+//
+// The pieces all move the same way mirrored left to right, so tables only
+// have positions with white's king on files a to d. They also move the same
+// way with the teams swapped and the board turned upside down, so there is
+// only a table for one way round of each material (KQvK, but not KvKQ).
+//
+// Only placements that can happen are numbered. The two kings are one of the
+// 1806 pairs of cells that aren't next to each other (with kings next to each
+// other the team to move just captures, so those aren't stored). Each other
+// piece goes on one of the cells still free, and pieces of the same kind are
+// numbered as a set, since swapping them gives the same position.
+
+// The most pieces (kings included) a table can have. A table with three
+// pieces has 223,944 positions, one with four 13.7 million (half that for
+// two pieces of one kind) and one with five up to 820 million. The values
+// are packed into as many bits as it takes to tell the table's different
+// values apart (5 or 6 for most tables), so a five piece table file takes
+// around 600 MB. TablebaseGenerator needs a byte per position while it
+// works a table out.
+constexpr int MAX_TABLEBASE_PIECES = 5;
+
+// Tables are stored in files named after the material with this extension
+// ("KQvK.sctb"). A file is a TABLEBASE_HEADER_SIZE byte header
+// (TABLEBASE_MAGIC, the number of pieces, their PieceCodes in the table's
+// order, the bits per value and how many different values there are), then
+// the different values (a byte each), then for each position the index of
+// its value in those, in that many bits. Position i's bits start at bit
+// i * bits, counting from the lowest bit of the first byte. Everything is
+// in bytes, so a file reads the same on any machine.
+constexpr char TABLEBASE_MAGIC[8] = {'S', 'C', 'T', 'B', '2', '\0', '\0', '\0'};
+constexpr size_t TABLEBASE_HEADER_SIZE = 16;
+constexpr const char* TABLEBASE_EXTENSION = ".sctb";
+
+// The pieces of a position and whose turn it is, the way the tables see it.
+struct TablebasePosition
+{
+    int count = 0;
+    PieceCode codes[MAX_TABLEBASE_PIECES] = {};
+    int squares[MAX_TABLEBASE_PIECES] = {};
+    Team turn = WHITE;
+};
+
+enum TablebaseOutcome
+{
+    TABLEBASE_DRAW,
+    TABLEBASE_WIN, // for the team to move
+    TABLEBASE_LOSS
+};
+
+struct TablebaseResult
+{
+    TablebaseOutcome outcome = TABLEBASE_DRAW;
+    // Until a king is captured, counting both teams' moves (0 for a draw).
+    int plies = 0;
+};
+
+// Read-only tablebases memory-mapped from files, ready for search players to
+// probe. Nothing changes after the constructor, so any number of threads can
+// use one Tablebases at once.
+class Tablebases
+{
+public:
+    // No tables, so every probe misses.
+    Tablebases() = default;
+    // Maps every table file in directory. Throws runtime_error if the
+    // directory can't be read or one of the files isn't a table.
+    explicit Tablebases(const std::string& directory);
+
+    size_t size() const { return tables.size(); }
+    // The most pieces in any of the tables (0 if there are none), so a
+    // search can skip probing positions with more pieces.
+    int max_pieces() const { return most_pieces; }
+
+    // Sets result to the result of board for the team to move and returns
+    // true, or returns false if there is no table for board's pieces.
+    bool probe(const Board& board, TablebaseResult& result) const;
+    // Sets move to the best of moves (the moves board.get_moves() returned)
+    // and result to what it leads to, the same as probe(board) would, and
+    // returns true. Returns false if some move leads to a position there is
+    // no table for.
+    bool best_move(const Board& board, const MoveList& moves, Move& move, TablebaseResult& result) const;
+
+private:
+    struct Table
+    {
+        MappedFile file{};
+        int bits = 0;
+        // The different values and the packed positions, in file.
+        const uint8_t* values = nullptr;
+        const uint8_t* packed = nullptr;
+    };
+
+    // Keyed by the material (see material_key in tablebase.cpp).
+    std::map<uint32_t, Table> tables;
+    int most_pieces = 0;
+};
+
+// Works tablebases out by retrograde analysis, on any number of threads.
+//
+// A position is a win in 1 if the team to move can capture the king, and a
+// draw if it has no moves. A loss in 2 is one where every move lets the other
+// team capture the king. Those come from looking at the moves of every
+// position. After that, sweep d = 3, 4 and so on only looks at positions one
+// move before a position sweep d - 1 decided, which it finds by taking that
+// move back: on odd sweeps they're wins in d, and on even sweeps they're
+// losses in d if every one of their moves leads to a win in less than d.
+// Captures lead into smaller tables, which are generated first, so each sweep
+// also takes captures back from the smaller tables' results in d - 1. Once
+// the sweeps stop finding anything, the positions left are draws. The moves
+// forward come from Board::get_moves, so the tables follow exactly the rules
+// the games do, and test_tablebase_moves checks the moves taken back against
+// them.
+class TablebaseGenerator
+{
+public:
+    explicit TablebaseGenerator(int threads = 1) : threads(threads), tables() {}
+
+    // Generates the table for material (e.g. "KQvK") and every table it needs
+    // (the materials left after a capture), unless they're already there.
+    // Throws invalid_argument if material isn't one a table can have.
+    void generate(const std::string& material);
+    // The names of the tables generated so far, smallest first.
+    std::vector<std::string> materials() const;
+    // Writes every table generated so far to directory, one file each.
+    // Throws runtime_error if it can't.
+    void write(const std::string& directory) const;
+
+private:
+    struct Table
+    {
+        std::vector<PieceCode> pieces{};
+        size_t size = 0;
+        // The longest win or loss, once the table is finished.
+        int longest = 0;
+        // Read and written by all threads at once during a sweep. What a sweep
+        // decides never depends on the values it writes itself, so relaxed
+        // loads and stores are enough.
+        std::unique_ptr<std::atomic<uint8_t>[]> values{};
+    };
+
+    // Generates the table for pieces (in the table's order), after the
+    // tables it needs.
+    void generate(const std::vector<PieceCode>& pieces);
+    // Looks at the moves of positions for results in distance and returns how
+    // many it decided: every position for distance 1 (which sets the table
+    // up), the undecided ones for losses in 2, and the candidates
+    // retrograde_sweep found for longer losses.
+    size_t sweep(uint32_t key, Table& table, int distance);
+    // Decides the positions one move before the ones with a result in
+    // distance - 1, in this table or (by a capture) in one of the smaller
+    // tables, and returns how many it decided.
+    size_t retrograde_sweep(uint32_t key, Table& table, int distance, const std::vector<uint32_t>& smaller);
+    // Whether every move from position leads to a win in less than distance.
+    // board must be empty, and is again afterwards.
+    bool loses_in(uint32_t key, const TablebasePosition& position, int distance, Board& board) const;
+    // The value of the position after move, for the team to move then.
+    uint8_t move_value(uint32_t key, const TablebasePosition& position, Move move) const;
+
+    int threads;
+    std::map<uint32_t, Table> tables;
+};
+
+#endif // _TABLEBASE_H_
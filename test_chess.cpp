@@ -1,14 +1,29 @@
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
 #include <string>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
 #include <vector>
 
+#include "attack_tables.h"
+#include "basic_board.h"
 #include "chess_pieces.h"
 #include "chess_board.h"
+#include "chess_game.h"
 #include "chess_player.h"
+#include "evaluation.h"
+#include "move_picker.h"
+#include "opening_book.h"
+#include "perft.h"
+#include "piece_moves.h"
+#include "sliding_attacks.h"
+#include "tablebase.h"
+#include "transposition_table.h"
 
 // algorithm
 using std::find;
@@ -61,7 +76,7 @@ void test_piece_identity()
 void test_get_and_make_moves()
 {
     Board board;
-    vector<Move> moves;
+    MoveList moves;
     // test initial conditions and individual pieces of a real chess game
     WHITE_PAWN.get_moves(board, Cell(0, 1), moves);
     WHITE_PAWN.make_move(board, moves[0]);
@@ -78,6 +93,8 @@ void test_get_and_make_moves()
         Move(Cell(0,2), Cell(0,3)),
         Move(Cell(0,0), Cell(0,1)),
         Move(Cell(0,0), Cell(0,2)),
+        Move(Cell(0,2), Cell(0,0)),
+        Move(Cell(0,2), Cell(0,1)),
         Move(Cell(0,2), Cell(1,2)),
         Move(Cell(0,2), Cell(2,2)),
         Move(Cell(0,2), Cell(3,2)),
@@ -85,8 +102,6 @@ void test_get_and_make_moves()
         Move(Cell(0,2), Cell(5,2)),
         Move(Cell(0,2), Cell(6,2)),
         Move(Cell(0,2), Cell(7,2)),
-        Move(Cell(0,2), Cell(0,1)),
-        Move(Cell(0,2), Cell(0,0)),
         Move(Cell(1,0), Cell(2,2)),
         Move(Cell(1,7), Cell(0,5)),
         Move(Cell(1,7), Cell(2,5))
@@ -116,7 +131,7 @@ void test_board()
 {
     // test board.get_moves(), which calls each piece's get_move() for the player turn, which is white by default
     Board board;
-    vector<Move> moves = board.get_moves();
+    MoveList moves = board.get_moves();
     assert_equals(12, moves.size(), "test_board: size of moves vector");
     vector<Move> expected_moves = {
         Move(Cell(1,0), Cell(0,2)), 
@@ -148,21 +163,901 @@ void test_board()
     }
 }
 
+void test_move_list()
+{
+    MoveList moves = {Move(Cell(0,1), Cell(0,2)), Move(Cell(1,0), Cell(2,2))};
+    assert_equals(2, moves.size(), "test_move_list: size after initializer list");
+    assert_equals(Move(Cell(1,0), Cell(2,2)), moves[1], "test_move_list: operator[]");
+    moves.clear();
+    assert_equals(true, moves.empty(), "test_move_list: empty after clear");
+    for (int i = 0; i < MoveList::CAPACITY; ++i)
+    {
+        moves.emplace_back(Cell(0,0), Cell(i % 8, i / 8 % 8));
+    }
+    try
+    {
+        moves.push_back(Move(Cell(0,0), Cell(1,1)));
+        throw UnitTestException("test_move_list: expected push_back on a full MoveList to throw");
+    }
+    catch (const out_of_range& e)
+    {
+    }
+    assert_equals(MoveList::CAPACITY, moves.size(), "test_move_list: size when full");
+
+    // Nine queens have at most 9 * 27 + 8 moves with their king, which fits,
+    // but ten could have more than a MoveList holds, so loading them throws.
+    const string nine_queens =
+        "   abcdefgh\n"
+        " 8 .......♚ 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 .♕♕♕♕♕♕♕ 2\n"
+        " 1 ♔♕♕..... 1\n"
+        "   abcdefgh\n";
+    Board board;
+    std::stringstream(nine_queens) >> board;
+    assert_equals(true, board.get_moves().size() <= size_t(MoveList::CAPACITY), "test_move_list: nine queens fit");
+    string ten_queens = nine_queens;
+    ten_queens.replace(ten_queens.find("♕♕....."), string("♕♕.....").size(), "♕♕♕....");
+    try
+    {
+        std::stringstream(ten_queens) >> board;
+        throw UnitTestException("test_move_list: expected loading ten queens to throw");
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+}
+
+void test_board_bitboards()
+{
+    Board board;
+    assert_equals(0xFFFF00000000FFFFull, board.occupancy(), "test_board_bitboards: initial occupancy");
+    assert_equals(0x000000000000FFFFull, board.pieces(WHITE), "test_board_bitboards: initial white pieces");
+    assert_equals(0xFFFF000000000000ull, board.pieces(BLACK), "test_board_bitboards: initial black pieces");
+    assert_equals(0x8100000000000081ull, board.pieces(ROOK), "test_board_bitboards: initial rooks");
+    assert_equals(0x1000000000000000ull, board.pieces(KING, BLACK), "test_board_bitboards: initial black king");
+
+    // b1 knight to c3, then a black pawn walks into the knight's reach and gets captured
+    board.make_move(Move(Cell(1,0), Cell(2,2)));
+    board.make_move(Move(Cell(1,6), Cell(1,5)));
+    board.make_move(Move(Cell(0,1), Cell(0,2)));
+    board.make_move(Move(Cell(1,5), Cell(1,4)));
+    board.make_move(Move(Cell(2,2), Cell(1,4)));
+    assert_equals(square_bit(to_square(Cell(1,4))) | square_bit(to_square(Cell(6,0))), board.pieces(KNIGHT, WHITE), "test_board_bitboards: white knights after capture");
+    assert_equals(0x00FD000000000000ull, board.pieces(PAWN, BLACK), "test_board_bitboards: black pawns after capture");
+    assert_equals(~board.occupancy(), board.pieces(NONE), "test_board_bitboards: empty cells");
+    assert_equals(true, board[Cell(1,4)] == WHITE_KNIGHT, "test_board_bitboards: operator[] after capture");
+
+    // loading a board from text fills in the bitboards
+    std::stringstream ss;
+    ss << board;
+    Board loaded;
+    ss >> loaded;
+    assert_equals(board.occupancy(), loaded.occupancy(), "test_board_bitboards: occupancy after operator>>");
+    assert_equals(board.pieces(PAWN), loaded.pieces(PAWN), "test_board_bitboards: pawns after operator>>");
+}
+
+void test_zobrist_hash()
+{
+    Board board;
+    assert_equals(board.compute_hash(), board.hash(), "test_zobrist_hash: hash after reset_board");
+    const uint64_t start_hash = board.hash();
+
+    // the same position reached by two move orders has the same hash
+    Board knights_first;
+    knights_first.make_move(Move(Cell(1,0), Cell(2,2)));
+    knights_first.make_move(Move(Cell(6,7), Cell(5,5)));
+    knights_first.make_move(Move(Cell(0,1), Cell(0,2)));
+    Board pawn_first;
+    pawn_first.make_move(Move(Cell(0,1), Cell(0,2)));
+    pawn_first.make_move(Move(Cell(6,7), Cell(5,5)));
+    pawn_first.make_move(Move(Cell(1,0), Cell(2,2)));
+    assert_equals(knights_first.hash(), pawn_first.hash(), "test_zobrist_hash: transposition");
+    assert_equals(knights_first.compute_hash(), knights_first.hash(), "test_zobrist_hash: incremental hash");
+
+    // a different position or a different turn changes the hash
+    UndoRecord undo = board.make_move(Move(Cell(0,1), Cell(0,2)));
+    assert_equals(true, board.hash() != start_hash, "test_zobrist_hash: hash after a move");
+    board.unmake_move(undo);
+    assert_equals(start_hash, board.hash(), "test_zobrist_hash: hash after unmake_move");
+
+    // CowardlyDogs and DarkKnights have their own keys
+    assert_equals(true, WHITE_COURAGE.zobrist_key(10) != WHITE_PAWN.zobrist_key(10), "test_zobrist_hash: CowardlyDog key");
+    assert_equals(true, BLACK_BATMAN.zobrist_key(10) != BLACK_KNIGHT.zobrist_key(10), "test_zobrist_hash: DarkKnight key");
+    assert_equals(0, EMPTY_SPACE.zobrist_key(10), "test_zobrist_hash: empty cells don't change the hash");
+
+    // loading a board from text works out the hash
+    std::stringstream ss;
+    ss << knights_first;
+    Board loaded;
+    loaded.make_move(Move(Cell(0,1), Cell(0,2)));  // so it's black's turn, like knights_first
+    ss >> loaded;
+    assert_equals(knights_first.hash(), loaded.hash(), "test_zobrist_hash: hash after operator>>");
+}
+
+// A custom piece that moves like a king but leaves a pawn behind where it was.
+class BreederKing : public SimpleChessPiece
+{
+public:
+    BreederKing() : SimpleChessPiece(U'♮', WHITE) {}
+    void get_moves(const Board& board, Cell from, MoveList& moves) const override
+    {
+        WHITE_KING.get_moves(board, from, moves);
+    }
+    void make_move(Board& board, Move move) const override
+    {
+        board.make_classical_chess_move(move);
+        board.place_piece(move.from, WHITE_PAWN);
+    }
+};
+
+void assert_same_board(const Board& expected, const Board& actual, const string& error_msg)
+{
+    for (int y = 0; y < 8; ++y)
+    {
+        for (int x = 0; x < 8; ++x)
+        {
+            assert_equals(expected[Cell(x, y)], actual[Cell(x, y)], error_msg);
+        }
+    }
+    assert_equals(expected.occupancy(), actual.occupancy(), error_msg);
+    assert_equals(expected.pieces(WHITE), actual.pieces(WHITE), error_msg);
+    assert_equals(expected.pieces(BLACK), actual.pieces(BLACK), error_msg);
+    assert_equals(expected.get_moves().size(), actual.get_moves().size(), error_msg);
+}
+
+void test_make_and_unmake_move()
+{
+    Board board;
+    const Board start = board;
+    vector<UndoRecord> undos;
+    undos.push_back(board.make_move(Move(Cell(1,0), Cell(2,2))));
+    undos.push_back(board.make_move(Move(Cell(1,6), Cell(1,5))));
+    undos.push_back(board.make_move(Move(Cell(0,1), Cell(0,2))));
+    undos.push_back(board.make_move(Move(Cell(1,5), Cell(1,4))));
+    const Board before_capture = board;
+    undos.push_back(board.make_move(Move(Cell(2,2), Cell(1,4))));
+    assert_equals(BLACK_PAWN, *undos.back().captured_piece, "test_make_and_unmake_move: captured piece");
+
+    board.unmake_move(undos.back());
+    undos.pop_back();
+    assert_same_board(before_capture, board, "test_make_and_unmake_move: unmake capture");
+    while (!undos.empty())
+    {
+        board.unmake_move(undos.back());
+        undos.pop_back();
+    }
+    assert_same_board(start, board, "test_make_and_unmake_move: unmake to start");
+
+    // custom pieces that change extra cells are undone too
+    const BreederKing breeder;
+    board.place_piece(Cell(3,3), breeder);
+    const Board before_breeder = board;
+    UndoRecord undo = board.make_move(Move(Cell(3,3), Cell(3,4)));
+    assert_equals(WHITE_PAWN, board[Cell(3,3)], "test_make_and_unmake_move: custom piece make_move");
+    board.unmake_move(undo);
+    assert_same_board(before_breeder, board, "test_make_and_unmake_move: custom piece unmake_move");
+}
+void test_perft()
+{
+    // the full corpus lives in tools/perft_corpus.txt, this keeps the basics in the unit tests
+    Board board;
+    const uint64_t start_hash = board.hash();
+    assert_equals(12, perft(board, 1), "test_perft: depth 1");
+    assert_equals(144, perft(board, 2), "test_perft: depth 2");
+    assert_equals(2124, perft(board, 3), "test_perft: depth 3");
+    assert_equals(31329, perft(board, 4), "test_perft: depth 4");
+    assert_equals(start_hash, board.hash(), "test_perft: board unchanged");
+
+    uint64_t divided = 0;
+    for (pair<Move, uint64_t> count : perft_divide(board, 3))
+    {
+        divided += count.second;
+    }
+    assert_equals(2124, divided, "test_perft: divide adds up");
+
+    // no moves after a king is captured
+    board.place_piece(Cell(4,7), EMPTY_SPACE);
+    assert_equals(0, perft(board, 2), "test_perft: game over");
+}
+
+// transposition table
+void test_transposition_table()
+{
+    TranspositionTable table(1);
+    assert_equals(true, table.capacity() * 16 <= 1024 * 1024, "test_transposition_table: memory budget");
+    assert_equals(0, table.capacity() & (table.capacity() - 1), "test_transposition_table: power of two capacity");
+
+    Board board;
+    TableEntry entry;
+    assert_equals(false, table.probe(board.hash(), entry), "test_transposition_table: empty table");
+
+    Move best_move(Cell(1,0), Cell(2,2));
+    table.store(board.hash(), 5, -1234, BOUND_LOWER, &best_move);
+    assert_equals(true, table.probe(board.hash(), entry), "test_transposition_table: probe after store");
+    assert_equals(5, entry.depth, "test_transposition_table: depth");
+    assert_equals(-1234, entry.score, "test_transposition_table: score");
+    assert_equals(BOUND_LOWER, entry.bound, "test_transposition_table: bound");
+    assert_equals(true, entry.has_best_move, "test_transposition_table: has best move");
+    assert_equals(best_move, entry.best_move, "test_transposition_table: best move");
+
+    // a result without a move keeps the move we already knew
+    table.store(board.hash(), 6, 50, BOUND_UPPER, nullptr);
+    table.probe(board.hash(), entry);
+    assert_equals(6, entry.depth, "test_transposition_table: depth after second store");
+    assert_equals(best_move, entry.best_move, "test_transposition_table: best move kept");
+
+    // a shallower result for another position in the same bucket doesn't push out the deep one
+    uint64_t other_hash = board.hash() ^ (uint64_t(1) << 63);
+    table.store(other_hash, 1, 7, BOUND_EXACT, nullptr);
+    assert_equals(true, table.probe(board.hash(), entry), "test_transposition_table: deep entry kept");
+    assert_equals(true, table.probe(other_hash, entry), "test_transposition_table: shallow entry stored");
+    assert_equals(7, entry.score, "test_transposition_table: shallow entry score");
+
+    table.clear();
+    assert_equals(false, table.probe(board.hash(), entry), "test_transposition_table: probe after clear");
+}
 
 // chess player
+Board board_from_string(const string& text, Team turn)
+{
+    std::stringstream ss(text);
+    Board board;
+    ss >> board;
+    board.set_turn(turn);
+    return board;
+}
+
+void test_search_player()
+{
+    // white can capture the black king right away
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ........ 8\n"
+        " 7 ........ 7\n"
+        " 6 ...♚.... 6\n"
+        " 5 ..♕..... 5\n"
+        " 4 ........ 4\n"
+        " 3 .☻...... 3\n"
+        " 2 ♙....... 2\n"
+        " 1 ....♔... 1\n"
+        "   abcdefgh\n", WHITE);
+    SearchLimits limits;
+    limits.milliseconds = 0;
+    limits.depth = 4;
+    SearchPlayer searcher(WHITE, limits, 1);
+    assert_equals(Move(Cell(2,4), Cell(3,5)), searcher.get_move(board, board.get_moves()), "test_search_player: capture the king");
+    assert_equals(true, searcher.last_search().score >= WIN_SCORE - 1, "test_search_player: king capture score");
+
+    // black's DarkKnight can grapple next to the rook and take the white king,
+    // so white has to move the king out of reach
+    board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ....♚... 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 ♖....... 2\n"
+        " 1 ♔......☻ 1\n"
+        "   abcdefgh\n", WHITE);
+    Move move = searcher.get_move(board, board.get_moves());
+    assert_equals(true, searcher.last_search().score > -WIN_SCORE / 2, "test_search_player: doesn't lose the king");
+    UndoRecord undo = board.make_move(move);
+    for (Move reply : board.get_moves())
+    {
+        assert_equals(false, board[reply.to] == WHITE_KING, "test_search_player: king left where it can be taken");
+    }
+    board.unmake_move(undo);
+
+    // searches stop at the depth and node budgets
+    limits.depth = 3;
+    SearchPlayer shallow(WHITE, limits, 1);
+    Board start;
+    shallow.get_move(start, start.get_moves());
+    assert_equals(3, shallow.last_search().depth, "test_search_player: depth limit");
+    limits.depth = MAX_SEARCH_DEPTH;
+    limits.nodes = 2000;
+    SearchPlayer budgeted(WHITE, limits, 1);
+    budgeted.get_move(start, start.get_moves());
+    assert_equals(true, budgeted.last_search().nodes <= 2000, "test_search_player: node budget");
+}
+
+void test_parallel_search()
+{
+    Board start;
+    MoveList moves = start.get_moves();
+
+    // one thread with a node budget gives the same answer every time
+    SearchLimits limits;
+    limits.milliseconds = 0;
+    limits.nodes = 20000;
+    SearchPlayer first(WHITE, limits, 1, 1);
+    SearchPlayer second(WHITE, limits, 1, 1);
+    assert_equals(first.get_move(start, moves), second.get_move(start, moves), "test_parallel_search: deterministic move");
+    assert_equals(first.last_search().nodes, second.last_search().nodes, "test_parallel_search: deterministic nodes");
+    assert_equals(1, first.last_search().thread_nodes.size(), "test_parallel_search: one thread");
+
+    // several threads share the table and report their own node counts
+    limits.nodes = 0;
+    limits.depth = 4;
+    SearchPlayer parallel(WHITE, limits, 1, 3);
+    Move move = parallel.get_move(start, moves);
+    assert_equals(true, find(moves.begin(), moves.end(), move) != moves.end(), "test_parallel_search: move from the list");
+    assert_equals(3, parallel.last_search().thread_nodes.size(), "test_parallel_search: nodes per thread");
+    assert_equals(4, parallel.last_search().depth, "test_parallel_search: depth");
+
+    // stop() ends a search long before its limits
+    limits.depth = MAX_SEARCH_DEPTH;
+    limits.milliseconds = 60000;
+    SearchPlayer unlimited(WHITE, limits, 1, 2);
+    std::thread stopper([&unlimited]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        unlimited.stop();
+    });
+    move = unlimited.get_move(start, moves);
+    stopper.join();
+    assert_equals(true, find(moves.begin(), moves.end(), move) != moves.end(), "test_parallel_search: move after stop");
+    assert_equals(true, unlimited.last_search().seconds < 30, "test_parallel_search: stopped early");
+}
+
+void test_get_captures()
+{
+    // Plays random games, with a BreederKing on the board, and checks the
+    // captures against filtering all the moves.
+    std::default_random_engine random(3);
+    BreederKing breeder;
+    for (int game = 0; game < 20; ++game)
+    {
+        Board board;
+        board.place_piece(Cell(3,2), breeder);
+        for (int turn = 0; turn < 60 && board.winner() == NONE; ++turn)
+        {
+            MoveList moves = board.get_moves();
+            if (moves.empty())
+            {
+                break;
+            }
+            MoveList expected_captures, expected_king_captures;
+            for (Move move : moves)
+            {
+                if (board[move.from].is_opposite_team(board[move.to]))
+                {
+                    expected_captures.push_back(move);
+                    if (board[move.to].type == KING)
+                    {
+                        expected_king_captures.push_back(move);
+                    }
+                }
+            }
+            MoveList captures = board.get_captures();
+            MoveList king_captures = board.get_king_captures();
+            assert_equals(expected_captures.size(), captures.size(), "test_get_captures: number of captures");
+            for (size_t i = 0; i < captures.size(); ++i)
+            {
+                assert_equals(expected_captures[i], captures[i], "test_get_captures: same captures in the same order");
+            }
+            assert_equals(expected_king_captures.size(), king_captures.size(), "test_get_captures: number of king captures");
+            assert_equals(moves.captures_king(), captures.captures_king(), "test_get_captures: captures_king");
+            assert_equals(moves.captures_king(), !king_captures.empty(), "test_get_captures: get_king_captures");
+            board.make_move(moves[random() % moves.size()]);
+        }
+    }
+}
+
+void test_is_legal()
+{
+    // Checks every from and to pair against get_moves in random games, with
+    // a BreederKing on the board.
+    std::default_random_engine random(5);
+    BreederKing breeder;
+    for (int game = 0; game < 5; ++game)
+    {
+        Board board;
+        board.place_piece(Cell(4,3), breeder);
+        for (int turn = 0; turn < 40 && board.winner() == NONE; ++turn)
+        {
+            MoveList moves = board.get_moves();
+            if (moves.empty())
+            {
+                break;
+            }
+            for (int from = 0; from < BOARD_SQUARES; ++from)
+            {
+                for (int to = 0; to < BOARD_SQUARES; ++to)
+                {
+                    Move move(to_cell(from), to_cell(to));
+                    assert_equals(find(moves.begin(), moves.end(), move) != moves.end(), board.is_legal(move), "test_is_legal: agrees with get_moves");
+                }
+            }
+            board.make_move(moves[random() % moves.size()]);
+        }
+    }
+    Board board;
+    assert_equals(false, board.is_legal(Move(Cell(0,1), Cell(0,8))), "test_is_legal: off the board");
+    assert_equals(false, board.is_legal(Move(Cell(0,6), Cell(0,5))), "test_is_legal: not this team's turn");
+}
+
+void test_mcts_player()
+{
+    // The black rook will take the white king unless it gets out of the way
+    // (to b1 or b2).
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ♜......♚ 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 ........ 2\n"
+        " 1 ♔.....♘. 1\n"
+        "   abcdefgh\n", WHITE);
+    MctsLimits limits;
+    limits.milliseconds = 0;
+    limits.playouts = 2000;
+    MctsPlayer player(WHITE, limits, 1 << 16);
+    Move move = player.get_move(board, board.get_moves());
+    assert_equals(true, move == Move(Cell(0,0), Cell(1,0)) || move == Move(Cell(0,0), Cell(1,1)), "test_mcts_player: king runs away");
+    assert_equals(2000, player.last_search().playouts, "test_mcts_player: playout budget");
+    assert_equals(true, player.last_search().nodes > 1, "test_mcts_player: tree grows");
+
+    // Same seed and one thread, same search.
+    MctsPlayer again(WHITE, limits, 1 << 16);
+    assert_equals(move, again.get_move(board, board.get_moves()), "test_mcts_player: repeatable");
+    assert_equals(player.last_search().nodes, again.last_search().nodes, "test_mcts_player: repeatable tree");
+
+    board.set_turn(BLACK);
+    assert_equals(Move(Cell(0,7), Cell(0,0)), player.get_move(board, board.get_moves()), "test_mcts_player: takes the king");
+
+    // Threads share the tree, with random rollouts, and a tree too small to
+    // hold much of anything.
+    Board start;
+    MoveList moves = start.get_moves();
+    limits.threads = 4;
+    limits.policy = RANDOM_ROLLOUTS;
+    limits.playouts = 4000;
+    MctsPlayer parallel(WHITE, limits, 100);
+    move = parallel.get_move(start, moves);
+    assert_equals(true, find(moves.begin(), moves.end(), move) != moves.end(), "test_mcts_player: parallel move");
+    assert_equals(true, parallel.last_search().playouts >= 4000, "test_mcts_player: parallel playouts");
+    assert_equals(100, parallel.last_search().nodes, "test_mcts_player: tree full");
+}
+
+void test_evaluation()
+{
+    Board board;
+    assert_equals(0, board.score(), "test_evaluation: the start is even");
+    assert_equals(board.compute_score(), board.score(), "test_evaluation: start score");
+
+    // White's knight to c3 is worth 10 + 20 more than on b1.
+    UndoRecord undo = board.make_move(Move(Cell(1,0), Cell(2,2)));
+    assert_equals(PIECE_SQUARE_BONUSES[KNIGHT][5 * 8 + 2] - PIECE_SQUARE_BONUSES[KNIGHT][7 * 8 + 1], board.score(), "test_evaluation: knight move");
+    assert_equals(-board.score(), evaluate(board), "test_evaluation: from black's point of view");
+    board.unmake_move(undo);
+    assert_equals(0, board.score(), "test_evaluation: unmake");
+
+    // Black's pieces score the same as white's, mirrored.
+    assert_equals(-piece_square_score(DARK_KNIGHT, WHITE, to_square(Cell(3,2))), piece_square_score(DARK_KNIGHT, BLACK, to_square(Cell(3,5))), "test_evaluation: mirrored");
+    assert_equals(PIECE_VALUES[QUEEN] + PIECE_SQUARE_BONUSES[QUEEN][7 * 8 + 3], piece_square_score(QUEEN, WHITE, to_square(Cell(3,0))), "test_evaluation: value and bonus");
+
+    // The running score matches a full count through random games, custom
+    // pieces and all.
+    std::default_random_engine random(9);
+    BreederKing breeder;
+    for (int game = 0; game < 10; ++game)
+    {
+        board.reset_board();
+        board.place_piece(Cell(3,3), breeder);
+        board.place_piece(Cell(2,1), WHITE_COURAGE);
+        board.place_piece(Cell(5,6), BLACK_BATMAN);
+        for (int turn = 0; turn < 80 && board.winner() == NONE; ++turn)
+        {
+            MoveList moves = board.get_moves();
+            if (moves.empty())
+            {
+                break;
+            }
+            int before = board.score();
+            Move move = moves[random() % moves.size()];
+            undo = board.make_move(move);
+            assert_equals(board.compute_score(), board.score(), "test_evaluation: after make_move");
+            board.unmake_move(undo);
+            assert_equals(before, board.score(), "test_evaluation: after unmake_move");
+            board.make_move(move);
+        }
+    }
+}
+
+void test_move_picker()
+{
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 .......♚ 8\n"
+        " 7 ♟....... 7\n"
+        " 6 ........ 6\n"
+        " 5 ...♛.... 5\n"
+        " 4 ....♙... 4\n"
+        " 3 ..♘..... 3\n"
+        " 2 ........ 2\n"
+        " 1 ♖......♔ 1\n"
+        "   abcdefgh\n", WHITE);
+    MoveList moves = board.get_moves();
+    size_t num_moves = moves.size();
+    MoveHistory history;
+    history.record_cutoff(Move(Cell(2,2), Cell(1,4)), 3, 2);
+    history.record_cutoff(Move(Cell(0,0), Cell(1,0)), 5, 4);
+    assert_equals(PackedMove(Move(Cell(2,2), Cell(1,4))), history.killer(3, 0), "test_move_picker: killer");
+    assert_equals(16, history.history(Move(Cell(0,0), Cell(1,0))), "test_move_picker: history");
+
+    Move hash_move(Cell(7,0), Cell(6,0));
+    MovePicker picker(board, moves, &hash_move, history, 3);
+    Move expected[] = {
+        hash_move,
+        Move(Cell(4,3), Cell(3,4)), // pawn takes queen
+        Move(Cell(2,2), Cell(3,4)), // knight takes queen
+        Move(Cell(0,0), Cell(0,6)), // rook takes pawn
+        Move(Cell(2,2), Cell(1,4)), // killer
+        Move(Cell(0,0), Cell(1,0)), // best history
+    };
+    MoveList picked;
+    Move move;
+    while (picker.next(move))
+    {
+        picked.push_back(move);
+    }
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+    {
+        assert_equals(expected[i], picked[i], "test_move_picker: order");
+    }
+    assert_equals(num_moves, picked.size(), "test_move_picker: every move");
+    for (size_t i = 0; i < picked.size(); ++i)
+    {
+        for (size_t j = i + 1; j < picked.size(); ++j)
+        {
+            assert_equals(false, picked[i] == picked[j], "test_move_picker: no move twice");
+        }
+    }
+
+    // A king capture comes before everything but the hash move, and a hash
+    // move that isn't one of the moves is skipped.
+    board.place_piece(Cell(1,4), BLACK_KING);
+    moves = board.get_moves();
+    Move missing(Cell(3,3), Cell(3,2));
+    MovePicker king_picker(board, moves, &missing, history, 0);
+    king_picker.next(move);
+    assert_equals(Move(Cell(2,2), Cell(1,4)), move, "test_move_picker: king capture first");
+}
+
+void test_quiescence()
+{
+    // the pawn on b7 looks free, but the knight takes the queen back just
+    // past the horizon of a depth 1 search
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ......♚. 8\n"
+        " 7 .♟...... 7\n"
+        " 6 ........ 6\n"
+        " 5 ..♞..... 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 .♕...... 2\n"
+        " 1 ♔....... 1\n"
+        "   abcdefgh\n", WHITE);
+    Move pawn_capture(Cell(1,1), Cell(1,6));
+    SearchLimits limits;
+    limits.milliseconds = 0;
+    limits.depth = 1;
+    limits.quiescence = false;
+    SearchPlayer horizon_searcher(WHITE, limits, 1);
+    assert_equals(pawn_capture, horizon_searcher.get_move(board, board.get_moves()), "test_quiescence: takes the pawn without quiescence");
+
+    limits.quiescence = true;
+    SearchPlayer searcher(WHITE, limits, 1);
+    assert_equals(false, searcher.get_move(board, board.get_moves()) == pawn_capture, "test_quiescence: sees the recapture");
+    assert_equals(true, searcher.last_search().score > 0, "test_quiescence: still ahead");
+}
+
+void test_opening_book()
+{
+    OpeningBookBuilder builder(2);
+    assert_equals(true, builder.add_game("b1c3 g8f6 c3d5 1-0"), "test_opening_book: game");
+    assert_equals(true, builder.add_game("b1c3 b8c6 1/2-1/2"), "test_opening_book: draw");
+    assert_equals(true, builder.add_game("g1f3 g8f6 0-1"), "test_opening_book: loss");
+    assert_equals(false, builder.add_game("3 games of search (a) vs search (b)"), "test_opening_book: not a game");
+    assert_equals(uint64_t(3), builder.games(), "test_opening_book: games");
+    // b1c3 and g1f3 from the start, and g8f6 and b8c6 after b1c3 and g8f6
+    // after g1f3. c3d5 is past the second ply.
+    assert_equals(size_t(5), builder.entries().size(), "test_opening_book: entries");
+    assert_equals(size_t(1), builder.entries(2).size(), "test_opening_book: entries with 2 games");
+    bool threw = false;
+    try
+    {
+        builder.add_game("b1b3 1-0");
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_opening_book: illegal move");
+
+    const char* path = "test_opening_book.bin";
+    assert_equals(size_t(5), builder.write(path), "test_opening_book: write");
+    {
+        OpeningBook book(path);
+        assert_equals(size_t(5), book.size(), "test_opening_book: size");
+        Board board;
+        Move move;
+        // b1c3 was played twice and scored 3 of 4 half points
+        assert_equals(true, book.probe(board, move), "test_opening_book: start position");
+        assert_equals(Move(Cell(1,0), Cell(2,2)), move, "test_opening_book: most played");
+        auto range = book.find(board.hash());
+        assert_equals(2L, range.second - range.first, "test_opening_book: moves from start");
+        assert_equals(uint16_t(750), range.first->score, "test_opening_book: score");
+
+        board.make_move(Move(Cell(6,0), Cell(5,2)));
+        assert_equals(true, book.probe(board, move), "test_opening_book: after g1f3");
+        assert_equals(Move(Cell(6,7), Cell(5,5)), move, "test_opening_book: g8f6");
+        board.make_move(move);
+        assert_equals(false, book.probe(board, move), "test_opening_book: out of book");
+
+        // the book moves first, then the player behind it
+        BookPlayer player(book, std::unique_ptr<Player>(new CapturePlayer(WHITE, 1)));
+        Board start;
+        assert_equals(Move(Cell(1,0), Cell(2,2)), player.get_move(start, start.get_moves()), "test_opening_book: BookPlayer");
+        assert_equals(true, board.is_legal(player.get_move(board, board.get_moves())), "test_opening_book: BookPlayer after the book");
+    }
+
+    // The entry count as a machine with the other byte order would read it.
+    FILE* swapped = fopen(path, "r+b");
+    unsigned char count[8];
+    fseek(swapped, 8, SEEK_SET);
+    assert_equals(size_t(8), fread(count, 1, 8, swapped), "test_opening_book: read count");
+    std::reverse(count, count + 8);
+    fseek(swapped, 8, SEEK_SET);
+    fwrite(count, 1, 8, swapped);
+    fclose(swapped);
+    threw = false;
+    try
+    {
+        OpeningBook book(path);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_opening_book: other byte order");
+    std::remove(path);
+
+    threw = false;
+    try
+    {
+        OpeningBook missing("no_such_opening_book.bin");
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_opening_book: missing file");
+}
+
+void test_tablebase()
+{
+    TablebaseGenerator generator(2);
+    generator.generate("KQvK");
+    assert_equals(size_t(2), generator.materials().size(), "test_tablebase: materials");
+    assert_equals(string("KvK"), generator.materials()[0], "test_tablebase: KvK comes first");
+    assert_equals(string("KQvK"), generator.materials()[1], "test_tablebase: KQvK");
+    bool threw = false;
+    try
+    {
+        generator.generate("KQ");
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_tablebase: not a material");
+
+    const char* directory = "test_tablebases";
+    mkdir(directory, 0755);
+    generator.write(directory);
+    {
+        Tablebases tablebases(directory);
+        assert_equals(size_t(2), tablebases.size(), "test_tablebase: tables");
+        assert_equals(3, tablebases.max_pieces(), "test_tablebase: max pieces");
+
+        // white captures the king in 9 plies (checked by brute force)
+        Board board = board_from_string(
+            "   abcdefgh\n"
+            " 8 ........ 8\n"
+            " 7 ......♕. 7\n"
+            " 6 ........ 6\n"
+            " 5 ........ 5\n"
+            " 4 .......♔ 4\n"
+            " 3 ........ 3\n"
+            " 2 ........ 2\n"
+            " 1 ..♚..... 1\n"
+            "   abcdefgh\n", WHITE);
+        TablebaseResult result;
+        assert_equals(true, tablebases.probe(board, result), "test_tablebase: KQvK");
+        assert_equals(TABLEBASE_WIN, result.outcome, "test_tablebase: win");
+        assert_equals(9, result.plies, "test_tablebase: win in 9");
+        Move move;
+        assert_equals(true, tablebases.best_move(board, board.get_moves(), move, result), "test_tablebase: best move");
+        assert_equals(9, result.plies, "test_tablebase: best move keeps the win");
+        board.make_move(move);
+        assert_equals(true, tablebases.probe(board, result), "test_tablebase: after the best move");
+        assert_equals(TABLEBASE_LOSS, result.outcome, "test_tablebase: loss");
+        assert_equals(8, result.plies, "test_tablebase: loss in 8");
+
+        // the same position mirrored left to right, and with the teams swapped
+        // and the board upside down
+        board = board_from_string(
+            "   abcdefgh\n"
+            " 8 ........ 8\n"
+            " 7 .♕...... 7\n"
+            " 6 ........ 6\n"
+            " 5 ........ 5\n"
+            " 4 ♔....... 4\n"
+            " 3 ........ 3\n"
+            " 2 ........ 2\n"
+            " 1 .....♚.. 1\n"
+            "   abcdefgh\n", WHITE);
+        assert_equals(true, tablebases.probe(board, result) && result.plies == 9, "test_tablebase: mirrored");
+        board = board_from_string(
+            "   abcdefgh\n"
+            " 8 ..♔..... 8\n"
+            " 7 ........ 7\n"
+            " 6 ........ 6\n"
+            " 5 .......♚ 5\n"
+            " 4 ........ 4\n"
+            " 3 ........ 3\n"
+            " 2 ......♛. 2\n"
+            " 1 ........ 1\n"
+            "   abcdefgh\n", BLACK);
+        assert_equals(true, tablebases.probe(board, result), "test_tablebase: KvKQ");
+        assert_equals(TABLEBASE_WIN, result.outcome, "test_tablebase: black wins");
+        assert_equals(9, result.plies, "test_tablebase: black wins in 9");
+
+        board = board_from_string(
+            "   abcdefgh\n"
+            " 8 .......♚ 8\n"
+            " 7 ........ 7\n"
+            " 6 ........ 6\n"
+            " 5 ........ 5\n"
+            " 4 ........ 4\n"
+            " 3 ........ 3\n"
+            " 2 ........ 2\n"
+            " 1 ♔....... 1\n"
+            "   abcdefgh\n", WHITE);
+        assert_equals(true, tablebases.probe(board, result), "test_tablebase: KvK");
+        assert_equals(TABLEBASE_DRAW, result.outcome, "test_tablebase: draw");
+        assert_equals(false, tablebases.probe(Board(), result), "test_tablebase: too many pieces");
+
+        // a search that can look positions up sees the whole win at depth 1
+        board = board_from_string(
+            "   abcdefgh\n"
+            " 8 ........ 8\n"
+            " 7 ......♕. 7\n"
+            " 6 ........ 6\n"
+            " 5 ........ 5\n"
+            " 4 .......♔ 4\n"
+            " 3 ........ 3\n"
+            " 2 ........ 2\n"
+            " 1 ..♚..... 1\n"
+            "   abcdefgh\n", WHITE);
+        SearchLimits limits;
+        limits.milliseconds = 0;
+        limits.depth = 1;
+        limits.tablebases = &tablebases;
+        SearchPlayer searcher(WHITE, limits, 1);
+        Move searched = searcher.get_move(board, board.get_moves());
+        assert_equals(WIN_SCORE - 9, searcher.last_search().score, "test_tablebase: search score");
+        board.make_move(searched);
+        assert_equals(true, tablebases.probe(board, result) && result.plies == 8, "test_tablebase: search move");
+    }
+    for (const string& material : generator.materials())
+    {
+        std::remove((string(directory) + "/" + material + TABLEBASE_EXTENSION).c_str());
+    }
+    rmdir(directory);
+}
+
+// Every position's value has to be the best its moves lead to, which checks
+// the moves the generator takes back against the ones a Board makes (the
+// cowardly dog's and the dark knight's are the odd ones).
+void test_tablebase_moves()
+{
+    TablebaseGenerator generator(2);
+    generator.generate("KDvK");
+    generator.generate("KMvK");
+    const char* directory = "test_tablebases_moves";
+    mkdir(directory, 0755);
+    generator.write(directory);
+    {
+        Tablebases tablebases(directory);
+        const ChessPiece* pieces[] = {&WHITE_COURAGE, &BLACK_COURAGE, &WHITE_BATMAN, &BLACK_BATMAN};
+        Board board = board_from_string(
+            "   abcdefgh\n"
+            " 8 ........ 8\n"
+            " 7 ........ 7\n"
+            " 6 ........ 6\n"
+            " 5 ........ 5\n"
+            " 4 ........ 4\n"
+            " 3 ........ 3\n"
+            " 2 ........ 2\n"
+            " 1 ........ 1\n"
+            "   abcdefgh\n", WHITE);
+        int checked = 0;
+        for (int white_king = 0; white_king < BOARD_SQUARES; ++white_king)
+        {
+            for (int black_king = 0; black_king < BOARD_SQUARES; ++black_king)
+            {
+                // Every third placement is plenty, and keeps it quick.
+                for (int square = (white_king + black_king) % 3; square < BOARD_SQUARES; square += 3)
+                {
+                    if (white_king == black_king || square == white_king || square == black_king)
+                    {
+                        continue;
+                    }
+                    const ChessPiece& piece = *pieces[(white_king + square) % 4];
+                    board.place_piece(to_cell(white_king), WHITE_KING);
+                    board.place_piece(to_cell(black_king), BLACK_KING);
+                    board.place_piece(to_cell(square), piece);
+                    for (Team turn : {WHITE, BLACK})
+                    {
+                        board.set_turn(turn);
+                        TablebaseResult result, best;
+                        assert_equals(true, tablebases.probe(board, result), "test_tablebase_moves: in a table");
+                        MoveList moves = board.get_moves();
+                        Move move;
+                        if (!moves.empty())
+                        {
+                            assert_equals(true, tablebases.best_move(board, moves, move, best), "test_tablebase_moves: best move");
+                        }
+                        if (result.outcome != best.outcome || result.plies != best.plies)
+                        {
+                            std::stringstream msg;
+                            msg << "test_tablebase_moves: " << team_name(turn) << " to move is " << result.plies
+                                << " plies from the end, but its moves say " << best.plies << " in\n" << board;
+                            throw UnitTestException(msg.str());
+                        }
+                        ++checked;
+                    }
+                    board.place_piece(to_cell(white_king), EMPTY_SPACE);
+                    board.place_piece(to_cell(black_king), EMPTY_SPACE);
+                    board.place_piece(to_cell(square), EMPTY_SPACE);
+                }
+            }
+        }
+        assert_equals(true, checked > 100000, "test_tablebase_moves: positions checked");
+    }
+    for (const string& material : generator.materials())
+    {
+        std::remove((string(directory) + "/" + material + TABLEBASE_EXTENSION).c_str());
+    }
+    rmdir(directory);
+}
+
 void test_players()
 {
     Board board;
     RandomPlayer rando(WHITE);
     CapturePlayer cap(BLACK);
     CheckMateCapturePlayer check(WHITE);
-    vector<Move> white_moves = {
+    MoveList white_moves = {
         Move(Cell(1,0), Cell(4,7)),  // killer move straight for the jugular
         Move(Cell(0,2), Cell(3,4)),  // random move
         Move(Cell(0,7), Cell(4,3)),  // random move
         Move(Cell(0,1), Cell(1,6))   // take a pawn
     };
-    vector<Move> black_moves = {
+    MoveList black_moves = {
         Move(Cell(0,2), Cell(3,4)),  // random move
         Move(Cell(0,7), Cell(4,3)),  // random move
         Move(Cell(1,6), Cell(0,1))   // take a pawn
@@ -180,6 +1075,433 @@ void test_players()
 }
 
 
+// chess game
+void test_play_one_chess_game()
+{
+    std::stringstream first_log, second_log;
+    RandomPlayer white(WHITE, 7), black(BLACK, 8);
+    Team first_winner = play_one_chess_game(white, black, first_log);
+    RandomPlayer white_again(WHITE, 7), black_again(BLACK, 8);
+    Team second_winner = play_one_chess_game(white_again, black_again, second_log);
+    assert_equals(true, first_winner != NONE, "test_play_one_chess_game: someone wins");
+    assert_equals(first_winner, second_winner, "test_play_one_chess_game: same seeds, same winner");
+    assert_equals(first_log.str(), second_log.str(), "test_play_one_chess_game: same seeds, same game");
+
+    std::stringstream short_log;
+    assert_equals(NONE, play_one_chess_game(white, black, short_log, 2), "test_play_one_chess_game: draw after max_turns");
+}
+
+void test_game_log()
+{
+    std::stringstream silent_output;
+    {
+        GameLog log(silent_output, LOG_NONE);
+        RandomPlayer white(WHITE, 7), black(BLACK, 8);
+        play_one_chess_game(white, black, log);
+    }
+    assert_equals(string(), silent_output.str(), "test_game_log: LOG_NONE writes nothing");
+
+    std::stringstream moves_output, interactive_output;
+    Team winner;
+    {
+        GameLog log(moves_output, LOG_MOVES);
+        RandomPlayer white(WHITE, 7), black(BLACK, 8);
+        winner = play_one_chess_game(white, black, log);
+    }
+    RandomPlayer white(WHITE, 7), black(BLACK, 8);
+    assert_equals(play_one_chess_game(white, black, interactive_output), winner, "test_game_log: same game as the ostream version");
+    string line = moves_output.str();
+    string result = winner == WHITE ? " 1-0\n" : " 0-1\n";
+    assert_equals(true, line.size() > result.size() && line.compare(line.size() - result.size(), result.size(), result) == 0,
+                  "test_game_log: LOG_MOVES line ends with the result");
+    string first_move = "from " + line.substr(0, 2) + " to " + line.substr(2, 2);
+    assert_equals(true, interactive_output.str().find(first_move) != string::npos, "test_game_log: LOG_MOVES starts with the first move");
+}
+
+
+void test_attack_tables()
+{
+    assert_equals(2, count_squares(KNIGHT_ATTACKS[to_square(Cell(0,0))]), "test_attack_tables: knight in the corner");
+    assert_equals(8, count_squares(KNIGHT_ATTACKS[to_square(Cell(3,3))]), "test_attack_tables: knight in the middle");
+    assert_equals(3, count_squares(KING_ATTACKS[to_square(Cell(7,7))]), "test_attack_tables: king in the corner");
+    assert_equals(square_bit(to_square(Cell(4,2))), PAWN_PUSHES[step_table_index(1)][to_square(Cell(4,1))], "test_attack_tables: white pawn push");
+    assert_equals(square_bit(to_square(Cell(4,0))), PAWN_PUSHES[step_table_index(-1)][to_square(Cell(4,1))], "test_attack_tables: black pawn push");
+    assert_equals(square_bit(to_square(Cell(1,2))), PAWN_ATTACKS[step_table_index(1)][to_square(Cell(0,1))], "test_attack_tables: pawn on the edge");
+    assert_equals(Bitboard(0), PAWN_PUSHES[step_table_index(1)][to_square(Cell(4,7))], "test_attack_tables: pawn on the last row");
+    assert_equals(Bitboard(0), PAWN_PUSHES[step_table_index(20)][to_square(Cell(4,0))], "test_attack_tables: long steps");
+    assert_equals(6, count_squares(FILE_RAYS[step_table_index(-1)][to_square(Cell(2,6))]), "test_attack_tables: retreat to the first row");
+
+    // A dog stuck behind a pawn can still capture, or run away to every empty
+    // cell behind it.
+    Board board;
+    board.place_piece(Cell(2,5), WHITE_COURAGE);
+    MoveList moves;
+    WHITE_COURAGE.get_moves(board, Cell(2,5), moves);
+    assert_equals(5, moves.size(), "test_attack_tables: dog moves");
+    // Each piece's moves come in cell order, so running away comes first.
+    assert_equals(Move(Cell(2,5), Cell(2,2)), moves[0], "test_attack_tables: dog runs away");
+    assert_equals(Move(Cell(2,5), Cell(1,6)), moves[3], "test_attack_tables: dog captures");
+}
+
+void test_sliding_attacks()
+{
+    // A rook on d4 with pieces on d6, b4 and d1.
+    Bitboard occupied = square_bit(to_square(Cell(3,5))) | square_bit(to_square(Cell(1,3))) | square_bit(to_square(Cell(3,0)));
+    int d4 = to_square(Cell(3,3));
+    assert_equals(11, count_squares(rook_attacks(d4, occupied)), "test_sliding_attacks: rook stops at pieces");
+    assert_equals(true, (rook_attacks(d4, occupied) & square_bit(to_square(Cell(3,6)))) == 0, "test_sliding_attacks: rook can't go past d6");
+    assert_equals(13, count_squares(bishop_attacks(d4, 0)), "test_sliding_attacks: bishop on an empty board");
+    assert_equals(24, count_squares(queen_attacks(d4, occupied)), "test_sliding_attacks: queen");
+
+    // Every method finds the same attacks as walking the rays.
+    Board board;
+    for (int square = 0; square < BOARD_SQUARES; ++square)
+    {
+        for (Bitboard occupancy : {Bitboard(0), board.occupancy(), occupied, ~Bitboard(0)})
+        {
+            for (SlidingAttackMethod method : {MAGIC, PEXT})
+            {
+                if (method == PEXT && !has_pext())
+                {
+                    continue;
+                }
+                assert_equals(rook_attacks(square, occupancy, RAY_WALK), rook_attacks(square, occupancy, method), "test_sliding_attacks: rook methods agree");
+                assert_equals(bishop_attacks(square, occupancy, RAY_WALK), bishop_attacks(square, occupancy, method), "test_sliding_attacks: bishop methods agree");
+            }
+        }
+    }
+}
+
+void test_dark_knight()
+{
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ........ 8\n"
+        " 7 ........ 7\n"
+        " 6 ...♜.... 6\n"
+        " 5 ...♙.... 5\n"
+        " 4 ...☺.... 4\n"
+        " 3 ........ 3\n"
+        " 2 ........ 2\n"
+        " 1 ♔.....♚. 1\n"
+        "   abcdefgh\n", WHITE);
+    MoveList moves;
+    WHITE_BATMAN.get_moves(board, Cell(3,3), moves);
+    // 22 queen moves (up to 4 cells), 8 knight jumps and 3 cells next to the
+    // rook that he can only reach with the grapple gun.
+    assert_equals(33, moves.size(), "test_dark_knight: number of moves");
+    for (size_t i = 0; i < moves.size(); ++i)
+    {
+        for (size_t j = i + 1; j < moves.size(); ++j)
+        {
+            assert_equals(false, moves[i] == moves[j], "test_dark_knight: no duplicate moves");
+        }
+    }
+    assert_equals(true, find(moves.begin(), moves.end(), Move(Cell(3,3), Cell(3,6))) != moves.end(), "test_dark_knight: grapple over a piece");
+    assert_equals(true, find(moves.begin(), moves.end(), Move(Cell(3,3), Cell(3,4))) == moves.end(), "test_dark_knight: can't land on his own team");
+    assert_equals(true, find(moves.begin(), moves.end(), Move(Cell(3,3), Cell(6,0))) != moves.end(), "test_dark_knight: captures");
+}
+
+void test_winner_and_king_captures()
+{
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ....♚... 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 ....♖... 2\n"
+        " 1 ♔....... 1\n"
+        "   abcdefgh\n", WHITE);
+    assert_equals(NONE, board.winner(), "test_winner_and_king_captures: both kings");
+    MoveList moves = board.get_moves();
+    assert_equals(true, moves.captures_king(), "test_winner_and_king_captures: rook can capture the king");
+    assert_equals(Move(Cell(4,1), Cell(4,7)), moves.king_capture(), "test_winner_and_king_captures: the capture");
+
+    UndoRecord undo = board.make_move(moves.king_capture());
+    assert_equals(WHITE, board.winner(), "test_winner_and_king_captures: white captured the king");
+    board.unmake_move(undo);
+    assert_equals(NONE, board.winner(), "test_winner_and_king_captures: unmake puts the king back");
+
+    board.set_turn(BLACK);
+    assert_equals(false, board.get_moves().captures_king(), "test_winner_and_king_captures: black king can't reach");
+    board.place_piece(Cell(0,0), EMPTY_SPACE);
+    assert_equals(BLACK, board.winner(), "test_winner_and_king_captures: no white king");
+}
+
+void test_piece_codes()
+{
+    assert_equals(make_piece_code(KNIGHT, WHITE), WHITE_KNIGHT.code, "test_piece_codes: white knight");
+    assert_equals(BLACK, code_team(BLACK_BATMAN.code), "test_piece_codes: team");
+    assert_equals(DARK_KNIGHT, code_type(BLACK_BATMAN.code), "test_piece_codes: type");
+    assert_equals(NO_PIECE, code_type(EMPTY_SPACE.code), "test_piece_codes: empty space");
+
+    // Pieces that aren't in ALL_CHESS_PIECES get their virtual functions called.
+    BreederKing breeder;
+    King other_king(U'♔', WHITE);
+    Pawn sideways_pawn(U'♙', WHITE, 0, true);
+    assert_equals(CUSTOM_PIECE, code_type(breeder.code), "test_piece_codes: custom piece");
+    assert_equals(CUSTOM_PIECE, code_type(other_king.code), "test_piece_codes: another king");
+    assert_equals(CUSTOM_PIECE, code_type(sideways_pawn.code), "test_piece_codes: pawn going a different way");
+
+    Board board;
+    assert_equals(WHITE_ROOK.code, board.code(to_square(Cell(0,0))), "test_piece_codes: board codes");
+    board.place_piece(Cell(3,3), breeder);
+    assert_equals(breeder.code, board.code(to_square(Cell(3,3))), "test_piece_codes: board codes after place_piece");
+    UndoRecord undo = board.make_move(Move(Cell(1,0), Cell(2,2)));
+    assert_equals(EMPTY_SPACE.code, board.code(to_square(Cell(1,0))), "test_piece_codes: board codes after a move");
+    board.unmake_move(undo);
+    assert_equals(WHITE_KNIGHT.code, board.code(to_square(Cell(1,0))), "test_piece_codes: board codes after unmake");
+}
+
+void test_packed_move()
+{
+    Move move(Cell(1,0), Cell(2,2));
+    PackedMove packed(move);
+    assert_equals(move, packed.move(), "test_packed_move: round trip");
+    assert_equals(to_square(Cell(1,0)), packed.from_square(), "test_packed_move: from square");
+    assert_equals(to_square(Cell(2,2)), packed.to_square(), "test_packed_move: to square");
+    assert_equals(false, packed.empty(), "test_packed_move: not empty");
+    assert_equals(true, PackedMove().empty(), "test_packed_move: empty");
+
+    std::stringstream text;
+    text << packed;
+    assert_equals(string("b1c3"), text.str(), "test_packed_move: operator<<");
+    PackedMove read;
+    text >> read;
+    assert_equals(packed, read, "test_packed_move: operator>>");
+
+    Board board = board_from_string(
+        "   abcdefgh\n"
+        " 8 ....♚... 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 ....♖..♟ 2\n"
+        " 1 ♔....... 1\n"
+        "   abcdefgh\n", WHITE);
+    assert_equals(0, board.pack_move(Move(Cell(4,1), Cell(4,4))).flags(), "test_packed_move: quiet move");
+    assert_equals(PackedMove::CAPTURE, board.pack_move(Move(Cell(4,1), Cell(7,1))).flags(), "test_packed_move: capture");
+    assert_equals(true, board.pack_move(Move(Cell(4,1), Cell(4,7))).is_king_capture(), "test_packed_move: king capture");
+    assert_equals(Move(Cell(4,1), Cell(4,7)), board.pack_move(Move(Cell(4,1), Cell(4,7))).move(), "test_packed_move: flags don't change the move");
+    BreederKing breeder;
+    board.place_piece(Cell(0,0), breeder);
+    assert_equals(true, board.pack_move(Move(Cell(0,0), Cell(0,1))).is_special(), "test_packed_move: custom piece");
+}
+
+void test_basic_board()
+{
+    const string big_board_text =
+        "   abcdefghij\n"
+        "10 ♚......... 10\n"
+        " 9 .......... 9\n"
+        " 8 .......... 8\n"
+        " 7 .......... 7\n"
+        " 6 .......... 6\n"
+        " 5 .......... 5\n"
+        " 4 .......... 4\n"
+        " 3 .......... 3\n"
+        " 2 .......... 2\n"
+        " 1 ♖........♔ 1\n"
+        "   abcdefghij\n";
+    BasicBoard<10, 10> board;
+    std::stringstream(big_board_text) >> board;
+    assert_equals(&WHITE_ROOK, &board[Cell(0,0)], "test_basic_board: operator>>");
+    assert_equals(&BLACK_KING, &board[Cell(0,9)], "test_basic_board: top row");
+    std::stringstream printed;
+    printed << board;
+    assert_equals(big_board_text, printed.str(), "test_basic_board: operator<<");
+
+    // 9 cells up and 8 across for the rook, 3 for the king.
+    BasicBoard<10, 10>::MoveList moves = board.get_moves();
+    assert_equals(20, moves.size(), "test_basic_board: number of moves");
+    assert_equals(true, moves.captures_king(), "test_basic_board: rook can capture the king");
+    assert_equals(Move(Cell(0,0), Cell(0,9)), moves.king_capture(), "test_basic_board: the capture");
+
+    UndoRecord undo = board.make_move(moves.king_capture());
+    assert_equals(WHITE, board.winner(), "test_basic_board: white captured the king");
+    assert_equals(BLACK, board.turn(), "test_basic_board: black's turn");
+    board.unmake_move(undo);
+    assert_equals(NONE, board.winner(), "test_basic_board: unmake puts the king back");
+    assert_equals(&WHITE_ROOK, &board[Cell(0,0)], "test_basic_board: unmake puts the rook back");
+
+    bool threw = false;
+    try
+    {
+        board.place_piece(Cell(10,0), WHITE_QUEEN);
+    }
+    catch (const std::out_of_range&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_basic_board: place_piece off the board");
+    threw = false;
+    try
+    {
+        BreederKing breeder;
+        board.place_piece(Cell(5,5), breeder);
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_basic_board: custom pieces only go on a Board");
+
+    threw = false;
+    try
+    {
+        Board small_board;
+        std::stringstream(big_board_text) >> small_board;
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_basic_board: Board only reads 8x8 boards");
+
+    std::stringstream big_board_stream(big_board_text);
+    int rows = 0;
+    visit_board(read_board_text(big_board_stream), [&](auto& visited) {
+        rows = visited.rows;
+        assert_equals(true, visited.winner() == NONE, "test_basic_board: visited board");
+    });
+    assert_equals(10, rows, "test_basic_board: visit_board picks 10x10");
+    std::stringstream start_stream;
+    start_stream << Board();
+    visit_board(read_board_text(start_stream), [&](auto& visited) { rows = visited.rows; });
+    assert_equals(8, rows, "test_basic_board: visit_board picks Board for 8x8");
+
+    // Eight queens with room to move have more moves than a Board's MoveList
+    // holds, so each big board sizes its MoveList for its own cells.
+    BasicBoard<12, 12> queens;
+    std::stringstream(
+        "   abcdefghijkl\n"
+        "12 ...........♚ 12\n"
+        "11 ............ 11\n"
+        "10 .....♕...... 10\n"
+        " 9 ....♕...♕... 9\n"
+        " 8 ......♕..... 8\n"
+        " 7 .........♕.. 7\n"
+        " 6 ..♕......... 6\n"
+        " 5 ............ 5\n"
+        " 4 .......♕.... 4\n"
+        " 3 ....♕....... 3\n"
+        " 2 ............ 2\n"
+        " 1 ♔........... 1\n"
+        "   abcdefghijkl\n") >> queens;
+    assert_equals(uint64_t(284), perft(queens, 1), "test_basic_board: eight queens on 12x12");
+    assert_equals(true, queens.get_moves().size() > size_t(MoveList::CAPACITY), "test_basic_board: more than a Board holds");
+
+    // Like a Board, a big board only loads pieces whose moves always fit. A
+    // DarkKnight could have 143 of the 576 a 12x12 MoveList holds, so three
+    // and a king fit but four don't.
+    auto dark_knights = [](const string& row_1) {
+        string text = "   abcdefghijkl\n"
+                      "12 ...........♚ 12\n";
+        for (int row = 11; row >= 2; --row)
+        {
+            text += (row < 10 ? " " : "") + std::to_string(row) + " ............ " + std::to_string(row) + "\n";
+        }
+        return text + " 1 " + row_1 + " 1\n"
+                      "   abcdefghijkl\n";
+    };
+    std::stringstream(dark_knights("♔☺☺☺........")) >> queens;
+    assert_equals(&WHITE_BATMAN, &queens[Cell(3,0)], "test_basic_board: three DarkKnights fit");
+    threw = false;
+    try
+    {
+        std::stringstream(dark_knights("♔☺☺☺☺.......")) >> queens;
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert_equals(true, threw, "test_basic_board: four DarkKnights could fill a MoveList");
+
+    // The big boards have captures, move checks and hashing too.
+    BasicBoard<10, 10>::MoveList captures = board.get_captures();
+    assert_equals(1, captures.size(), "test_basic_board: the rook's capture");
+    assert_equals(true, captures.captures_king(), "test_basic_board: captures the king");
+    assert_equals(true, board.is_legal(Move(Cell(0,0), Cell(8,0))), "test_basic_board: rook along the row");
+    assert_equals(false, board.is_legal(Move(Cell(0,0), Cell(9,0))), "test_basic_board: not onto the king");
+    assert_equals(false, board.is_legal(Move(Cell(0,9), Cell(0,8))), "test_basic_board: not black's turn");
+    uint64_t hash = board.hash();
+    assert_equals(board.compute_hash(), hash, "test_basic_board: hash kept up to date");
+    undo = board.make_move(Move(Cell(0,0), Cell(0,5)));
+    assert_equals(true, board.hash() != hash, "test_basic_board: hash changes");
+    assert_equals(board.compute_hash(), board.hash(), "test_basic_board: hash after a move");
+    board.unmake_move(undo);
+    assert_equals(hash, board.hash(), "test_basic_board: hash after unmake");
+}
+
+void test_piece_rules()
+{
+    // Board finds moves through BitboardGeometry and the big boards through
+    // CellGeometry, with the same rules. Plays random games with every kind
+    // of built in piece on the board and checks that both geometries agree
+    // on where every piece can go.
+    std::default_random_engine random(17);
+    for (int game = 0; game < 20; ++game)
+    {
+        Board board;
+        board.place_piece(Cell(2,2), WHITE_COURAGE);
+        board.place_piece(Cell(5,5), BLACK_COURAGE);
+        board.place_piece(Cell(3,3), WHITE_BATMAN);
+        board.place_piece(Cell(4,4), BLACK_BATMAN);
+        board.place_piece(Cell(7,3), WHITE_ROOK);
+        for (int turn = 0; turn < 80 && board.winner() == NONE; ++turn)
+        {
+            PieceCode codes[BOARD_SQUARES];
+            for (int square = 0; square < BOARD_SQUARES; ++square)
+            {
+                codes[square] = board.code(square);
+            }
+            BitboardGeometry bitboards(board);
+            CellGeometry<8, 8> cells(codes);
+            for (int square = 0; square < BOARD_SQUARES; ++square)
+            {
+                Bitboard expected = piece_targets(bitboards, codes[square], square);
+                assert_equals(expected, Bitboard(piece_targets(cells, codes[square], square).to_ullong()),
+                              "test_piece_rules: both geometries agree");
+            }
+            MoveList moves = board.get_moves();
+            if (moves.empty())
+            {
+                break;
+            }
+            board.make_move(moves[random() % moves.size()]);
+        }
+    }
+
+    // Both geometries bound a piece's moves the same way too.
+    Board empty_board;
+    std::stringstream(
+        "   abcdefgh\n"
+        " 8 ........ 8\n"
+        " 7 ........ 7\n"
+        " 6 ........ 6\n"
+        " 5 ........ 5\n"
+        " 4 ........ 4\n"
+        " 3 ........ 3\n"
+        " 2 ........ 2\n"
+        " 1 ........ 1\n"
+        "   abcdefgh\n") >> empty_board;
+    PieceCode empty_codes[BOARD_SQUARES];
+    std::fill(empty_codes, empty_codes + BOARD_SQUARES, EMPTY_SPACE.code);
+    const int expected_most[] = {0, 8, 27, 13, 8, 14, 3, 9, 63};
+    for (int type = NO_PIECE; type <= DARK_KNIGHT; ++type)
+    {
+        assert_equals(expected_most[type], most_moves(BitboardGeometry(empty_board), static_cast<PieceType>(type)),
+                      "test_piece_rules: most moves on a Board");
+        assert_equals(expected_most[type], most_moves(CellGeometry<8, 8>(empty_codes), static_cast<PieceType>(type)),
+                      "test_piece_rules: most moves on an 8x8 CellGeometry");
+    }
+}
+
 // int main()
 // {
 //     try
@@ -188,7 +1510,34 @@ void test_players()
 //         test_piece_identity();
 //         test_get_and_make_moves();
 //         test_board();
+//         test_move_list();
+//         test_board_bitboards();
+//         test_zobrist_hash();
+//         test_make_and_unmake_move();
+//         test_perft();
+//         test_transposition_table();
+//         test_search_player();
+//         test_parallel_search();
+//         test_get_captures();
+//         test_is_legal();
+//         test_mcts_player();
+//         test_evaluation();
+//         test_move_picker();
+//         test_quiescence();
+//         test_opening_book();
+//         test_tablebase();
+//         test_tablebase_moves();
 //         test_players();
+//         test_play_one_chess_game();
+//         test_game_log();
+//         test_attack_tables();
+//         test_sliding_attacks();
+//         test_dark_knight();
+//         test_winner_and_king_captures();
+//         test_piece_codes();
+//         test_packed_move();
+//         test_basic_board();
+//         test_piece_rules();
 //     }
 //     catch (UnitTestException& e)
 //     {
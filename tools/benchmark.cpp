@@ -0,0 +1,207 @@
+// benchmark: times the low level pieces of move generation against each
+// other, on positions from real (random) games.
+//
+// Usage:
+//   benchmark sliders [positions]
+//       Times rook, bishop and queen attacks found by walking the rays one
+//       cell at a time (the way the pieces used to), by magic multiply and
+//       by PEXT (if this processor has it), over the sliding pieces in
+//       positions positions (default 100000).
+//   benchmark legality [positions]
+//       Times checking moves with Board::is_legal against searching the list
+//       from get_moves, for every move in positions positions (default
+//       100000) and as many moves that aren't legal.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../bitboard.h"
+#include "../chess_board.h"
+#include "../sliding_attacks.h"
+
+using namespace std;
+
+// Plays random games from the start position and collects the positions
+// along the way.
+vector<Board> random_positions(int count, unsigned seed)
+{
+    vector<Board> positions;
+    mt19937 random(seed);
+    Board board;
+    while (static_cast<int>(positions.size()) < count)
+    {
+        MoveList moves = board.get_moves();
+        if (moves.empty() || board.winner() != NONE)
+        {
+            board.reset_board();
+            continue;
+        }
+        board.make_move(moves[random() % moves.size()]);
+        positions.push_back(board);
+    }
+    return positions;
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+struct SliderSample
+{
+    int square;
+    Bitboard occupied;
+    PieceType type;
+};
+
+// Looks up every sample's attacks with method, repeats times over. Returns
+// the XOR of all the attacks, so different methods can be checked against
+// each other (and the work can't be optimized away).
+Bitboard time_sliders(const vector<SliderSample>& samples, SlidingAttackMethod method, int repeats, double& seconds)
+{
+    Bitboard checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+        for (const SliderSample& sample : samples)
+        {
+            Bitboard attacks = 0;
+            if (sample.type != BISHOP)
+            {
+                attacks |= rook_attacks(sample.square, sample.occupied, method);
+            }
+            if (sample.type != ROOK)
+            {
+                attacks |= bishop_attacks(sample.square, sample.occupied, method);
+            }
+            checksum ^= attacks + static_cast<Bitboard>(i);
+        }
+    }
+    seconds = seconds_since(start);
+    return checksum;
+}
+
+int run_sliders(int num_positions)
+{
+    vector<SliderSample> samples;
+    for (const Board& board : random_positions(num_positions, 1))
+    {
+        for (PieceType type : {ROOK, BISHOP, QUEEN})
+        {
+            Bitboard pieces = board.pieces(type);
+            while (pieces)
+            {
+                samples.push_back({pop_lowest_square(pieces), board.occupancy(), type});
+            }
+        }
+    }
+    cout << samples.size() << " rooks, bishops and queens in " << num_positions << " positions\n";
+
+    const int repeats = 20;
+    const char* names[] = {"ray walk", "magic", "pext"};
+    Bitboard expected = 0;
+    for (SlidingAttackMethod method : {RAY_WALK, MAGIC, PEXT})
+    {
+        if (method == PEXT && !has_pext())
+        {
+            cout << names[method] << ": not supported on this processor\n";
+            continue;
+        }
+        double seconds;
+        Bitboard checksum = time_sliders(samples, method, repeats, seconds);
+        if (method == RAY_WALK)
+        {
+            expected = checksum;
+        }
+        double lookups = static_cast<double>(samples.size()) * repeats;
+        cout << names[method] << ": " << seconds << "s (" << static_cast<uint64_t>(lookups / seconds)
+             << " lookups/s)" << (checksum == expected ? "" : " WRONG ATTACKS") << '\n';
+        if (checksum != expected)
+        {
+            return 1;
+        }
+    }
+    cout << "rook_attacks and bishop_attacks use " << names[sliding_attack_method()] << endl;
+    return 0;
+}
+
+struct LegalitySample
+{
+    size_t position;
+    Move move;
+};
+
+int run_legality(int num_positions)
+{
+    vector<Board> positions = random_positions(num_positions, 2);
+    // The move list a game server would already have for each position, and
+    // the moves clients send: half of them legal, and half from a random cell
+    // to a random cell (which almost never are).
+    vector<MoveList> move_lists;
+    vector<LegalitySample> samples;
+    mt19937 random(3);
+    for (size_t position = 0; position < positions.size(); ++position)
+    {
+        move_lists.push_back(positions[position].get_moves());
+        for (Move move : move_lists.back())
+        {
+            samples.push_back({position, move});
+            samples.push_back({position, Move(to_cell(static_cast<int>(random() % BOARD_SQUARES)),
+                                              to_cell(static_cast<int>(random() % BOARD_SQUARES)))});
+        }
+    }
+    cout << samples.size() << " moves in " << num_positions << " positions\n";
+
+    auto start = chrono::steady_clock::now();
+    size_t found = 0;
+    for (const LegalitySample& sample : samples)
+    {
+        const MoveList& moves = move_lists[sample.position];
+        found += find(moves.begin(), moves.end(), sample.move) != moves.end();
+    }
+    double find_seconds = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    size_t legal = 0;
+    for (const LegalitySample& sample : samples)
+    {
+        legal += positions[sample.position].is_legal(sample.move);
+    }
+    double legal_seconds = seconds_since(start);
+
+    double checks = static_cast<double>(samples.size());
+    cout << "find in move list: " << find_seconds << "s (" << static_cast<uint64_t>(checks / find_seconds) << " checks/s)\n";
+    cout << "Board::is_legal: " << legal_seconds << "s (" << static_cast<uint64_t>(checks / legal_seconds) << " checks/s)"
+         << (legal == found ? "" : " WRONG ANSWERS") << endl;
+    return legal == found ? 0 : 1;
+}
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        if (argc >= 2 && strcmp(argv[1], "sliders") == 0)
+        {
+            return run_sliders(argc >= 3 ? stoi(argv[2]) : 100000);
+        }
+        if (argc >= 2 && strcmp(argv[1], "legality") == 0)
+        {
+            return run_legality(argc >= 3 ? stoi(argv[2]) : 100000);
+        }
+        cerr << "Usage: " << argv[0] << " sliders [positions]\n"
+             << "       " << argv[0] << " legality [positions]" << endl;
+        return 2;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
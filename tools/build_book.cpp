@@ -0,0 +1,86 @@
+// build_book: builds an opening book (see OpeningBook) from games logged by
+// tournament with --log moves.
+//
+// Usage:
+//   build_book <book file> [--plies N] [--min-games G] [log file ...]
+// Reads the games from the log files, or from stdin if there are none, so a
+// book can be built straight from self-play:
+//   tournament 10000 search search --log moves | build_book book.bin
+// Only the first --plies moves of each game (default 16) go in the book, and
+// only moves played in at least --min-games games (default 2). Lines that
+// aren't games, like tournament's summary, are skipped.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../opening_book.h"
+
+using namespace std;
+
+void add_games(istream& is, OpeningBookBuilder& builder)
+{
+    string line;
+    while (getline(is, line))
+    {
+        builder.add_game(line);
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        if (argc < 2)
+        {
+            cerr << "Usage: " << argv[0] << " <book file> [--plies N] [--min-games G] [log file ...]" << endl;
+            return 2;
+        }
+        string book_path = argv[1];
+        int plies = 16;
+        uint32_t min_games = 2;
+        vector<string> log_paths;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--plies") == 0 && i + 1 < argc)
+            {
+                plies = stoi(argv[++i]);
+            }
+            else if (strcmp(argv[i], "--min-games") == 0 && i + 1 < argc)
+            {
+                min_games = static_cast<uint32_t>(stoul(argv[++i]));
+            }
+            else
+            {
+                log_paths.push_back(argv[i]);
+            }
+        }
+
+        OpeningBookBuilder builder(plies);
+        if (log_paths.empty())
+        {
+            add_games(cin, builder);
+        }
+        for (const string& path : log_paths)
+        {
+            ifstream log(path);
+            if (!log)
+            {
+                throw runtime_error("Can't open " + path);
+            }
+            add_games(log, builder);
+        }
+        size_t book_moves = builder.write(book_path, min_games);
+        cout << builder.games() << " games, " << book_moves << " book moves written to " << book_path << endl;
+        return 0;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
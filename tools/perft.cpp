@@ -0,0 +1,215 @@
+// perft: counts move generation leaf nodes, for checking move generation is
+// correct and measuring how fast it is.
+//
+// Usage:
+//   perft <depth> [position file] [--divide]
+//       Counts the nodes depth moves from the start position (or the first
+//       position in position file) and reports nodes per second. --divide
+//       also prints the count after each first move.
+//   perft --corpus <corpus file>
+//       Checks every count in corpus file and reports nodes per second.
+//
+// Position and corpus files are made of entries like this:
+//   position <name>
+//   turn <white|black>
+//   <a board as printed by operator<<(ostream&, const Board&), which can
+//    also be 10x10 or 12x12>
+//   perft <depth> <nodes>
+//   ...
+// Lines that are empty or start with # are skipped.
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../basic_board.h"
+#include "../chess_board.h"
+#include "../chess_pieces.h"
+#include "../perft.h"
+
+using namespace std;
+
+struct PerftPosition
+{
+    string name;
+    BoardText board;
+    Team turn;
+    vector<pair<int, uint64_t> > expected;
+};
+
+vector<PerftPosition> read_perft_positions(istream& is)
+{
+    vector<PerftPosition> positions;
+    string line;
+    while (getline(is, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        stringstream ss(line);
+        string keyword;
+        ss >> keyword;
+        if (keyword == "position")
+        {
+            positions.push_back({"", BoardText(), WHITE, {}});
+            ss >> positions.back().name;
+            string turn_line, turn_keyword, turn;
+            getline(is, turn_line);
+            stringstream(turn_line) >> turn_keyword >> turn;
+            if (turn_keyword != "turn" || (turn != "white" && turn != "black"))
+            {
+                throw runtime_error("Expected 'turn white' or 'turn black' after position " + positions.back().name);
+            }
+            positions.back().board = read_board_text(is);
+            positions.back().turn = turn == "white" ? WHITE : BLACK;
+        }
+        else if (keyword == "perft" && !positions.empty())
+        {
+            int depth;
+            uint64_t nodes;
+            ss >> depth >> nodes;
+            positions.back().expected.emplace_back(depth, nodes);
+        }
+        else
+        {
+            throw runtime_error("Could not understand perft file line: " + line);
+        }
+    }
+    return positions;
+}
+
+vector<PerftPosition> read_perft_file(const char* filename)
+{
+    ifstream file(filename);
+    if (!file)
+    {
+        throw runtime_error(string("Could not open ") + filename);
+    }
+    return read_perft_positions(file);
+}
+
+double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int run_corpus(const char* filename)
+{
+    int failures = 0;
+    uint64_t total_nodes = 0;
+    double total_seconds = 0;
+    for (const PerftPosition& position : read_perft_file(filename))
+    {
+        visit_board(position.board, [&](auto& board) {
+            board.set_turn(position.turn);
+            for (pair<int, uint64_t> expected : position.expected)
+            {
+                auto start = chrono::steady_clock::now();
+                uint64_t nodes = perft(board, expected.first);
+                double seconds = seconds_since(start);
+                total_nodes += nodes;
+                total_seconds += seconds;
+                bool ok = nodes == expected.second;
+                failures += !ok;
+                cout << (ok ? "ok   " : "FAIL ") << position.name << " depth " << expected.first
+                     << ": " << nodes << " nodes";
+                if (!ok)
+                {
+                    cout << " (expected " << expected.second << ")";
+                }
+                cout << '\n';
+            }
+        });
+    }
+    cout << total_nodes << " nodes in " << total_seconds << "s ("
+         << static_cast<uint64_t>(total_nodes / total_seconds) << " nodes/s)\n";
+    cout << (failures ? "FAILED: " : "passed: ") << failures << " wrong counts" << endl;
+    return failures ? 1 : 0;
+}
+
+template <class BoardType>
+void run_perft(BoardType& board, int depth, bool divide)
+{
+    cout << board << team_name(board.turn()) << "'s turn.\n";
+
+    auto start = chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    if (divide)
+    {
+        for (pair<Move, uint64_t> count : perft_divide(board, depth))
+        {
+            cout << count.first << ": " << count.second << '\n';
+            nodes += count.second;
+        }
+    }
+    else
+    {
+        nodes = perft(board, depth);
+    }
+    double seconds = seconds_since(start);
+    cout << "perft " << depth << ": " << nodes << " nodes in " << seconds << "s ("
+         << static_cast<uint64_t>(nodes / seconds) << " nodes/s)" << endl;
+}
+
+int run_perft(int depth, const char* filename, bool divide)
+{
+    if (!filename)
+    {
+        Board board;
+        run_perft(board, depth, divide);
+        return 0;
+    }
+    vector<PerftPosition> positions = read_perft_file(filename);
+    if (positions.empty())
+    {
+        throw runtime_error(string("No positions in ") + filename);
+    }
+    visit_board(positions[0].board, [&](auto& board) {
+        board.set_turn(positions[0].turn);
+        run_perft(board, depth, divide);
+    });
+    return 0;
+}
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        if (argc == 3 && strcmp(argv[1], "--corpus") == 0)
+        {
+            return run_corpus(argv[2]);
+        }
+        if (argc < 2)
+        {
+            cerr << "Usage: " << argv[0] << " <depth> [position file] [--divide]\n"
+                 << "       " << argv[0] << " --corpus <corpus file>" << endl;
+            return 2;
+        }
+        int depth = stoi(argv[1]);
+        const char* filename = nullptr;
+        bool divide = false;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--divide") == 0)
+            {
+                divide = true;
+            }
+            else
+            {
+                filename = argv[i];
+            }
+        }
+        return run_perft(depth, filename, divide);
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
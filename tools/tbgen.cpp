@@ -0,0 +1,71 @@
+// tbgen: generates endgame tablebases (see TablebaseGenerator) and writes
+// them to a directory, for Tablebases to map.
+//
+// Usage:
+//   tbgen <directory> <material> [material ...] [--threads N]
+// e.g. `tbgen tables KQvK KRvK KQvKR --threads 8`. Every table a material
+// needs (KvK for KQvK) is generated and written too. Tables with three
+// pieces (under 200 KiB each) take under a second on one thread, with four
+// (up to 12 MB) about a minute and with five (up to 600 MB on disk and
+// 820 MB in memory while it's generated) hours, so give those all the
+// threads and memory there are.
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../tablebase.h"
+
+using namespace std;
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        if (argc < 3)
+        {
+            cerr << "Usage: " << argv[0] << " <directory> <material> [material ...] [--threads N]" << endl;
+            return 2;
+        }
+        string directory = argv[1];
+        int threads = thread::hardware_concurrency() ? static_cast<int>(thread::hardware_concurrency()) : 1;
+        vector<string> materials;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                threads = stoi(argv[++i]);
+            }
+            else
+            {
+                materials.push_back(argv[i]);
+            }
+        }
+
+        TablebaseGenerator generator(threads);
+        for (const string& material : materials)
+        {
+            auto start = chrono::steady_clock::now();
+            generator.generate(material);
+            cout << material << ": " << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+                 << "s on " << threads << " threads" << endl;
+        }
+        generator.write(directory);
+        cout << "Wrote";
+        for (const string& material : generator.materials())
+        {
+            cout << ' ' << material << TABLEBASE_EXTENSION;
+        }
+        cout << " to " << directory << endl;
+        return 0;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
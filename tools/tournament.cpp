@@ -0,0 +1,325 @@
+// tournament: plays many games between two kinds of Player on a pool of
+// threads and reports how many each side won and how many games per second
+// were played.
+//
+// Usage:
+//   tournament <games> <player a> <player b> [--threads N] [--seed S]
+//              [--max-turns T] [--search-ms M] [--log none|result|moves|boards]
+//              [--book FILE] [--tablebases DIRECTORY]
+// Players are random, capture, checkmate, search or mcts (which, like search,
+// gets --search-ms milliseconds per move). Player a plays white in
+// even numbered games and black in odd numbered games. Every game gets its
+// own seed (from --seed and the game number) so a run can be repeated.
+// Games longer than --max-turns turns (default 500) are draws. --log writes
+// each game to stdout at that level of detail (see LogLevel); the default is
+// none, which doesn't format anything. With --book both players play from
+// that opening book (see build_book) until their game leaves it, and with
+// --tablebases search players look up endgames in the tables in that
+// directory (see tbgen).
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../chess_board.h"
+#include "../chess_game.h"
+#include "../chess_player.h"
+#include "../opening_book.h"
+#include "../tablebase.h"
+
+using namespace std;
+
+// Hands out game numbers to worker threads. Each worker owns a deque of game
+// numbers and plays games from the back of it. When its own deque runs out it
+// steals from the front of another worker's deque, so no worker sits idle
+// while there are games left anywhere (some games take much longer than
+// others).
+class WorkStealingScheduler
+{
+public:
+    WorkStealingScheduler(size_t num_workers, int num_tasks) : queues()
+    {
+        for (size_t i = 0; i < num_workers; ++i)
+        {
+            queues.emplace_back(new WorkQueue);
+        }
+        // Deal out the tasks in one block per worker.
+        for (int task = 0; task < num_tasks; ++task)
+        {
+            queues[static_cast<size_t>(task) * queues.size() / static_cast<size_t>(num_tasks)]->tasks.push_back(task);
+        }
+    }
+
+    // Sets task to the next task for worker. Returns false when there are none left.
+    bool next_task(size_t worker, int& task)
+    {
+        for (size_t i = 0; i < queues.size(); ++i)
+        {
+            WorkQueue& queue = *queues[(worker + i) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (!queue.tasks.empty())
+            {
+                if (i == 0)
+                {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct WorkQueue
+    {
+        mutex lock{};
+        deque<int> tasks{};
+    };
+    vector<unique_ptr<WorkQueue> > queues;
+};
+
+struct TournamentOptions
+{
+    int games = 0;
+    string player_a{}, player_b{};
+    size_t threads = thread::hardware_concurrency() ? thread::hardware_concurrency() : 1;
+    unsigned seed = 1;
+    int max_turns = 500;
+    int search_milliseconds = 10;
+    LogLevel log_level = LOG_NONE;
+    string book_path{};
+    string tablebase_directory{};
+    // Mapped from tablebase_directory in main, if there is one.
+    const Tablebases* tablebases = nullptr;
+};
+
+LogLevel parse_log_level(const string& name)
+{
+    const char* names[] = {"none", "result", "moves", "boards"};
+    for (int level = LOG_NONE; level <= LOG_BOARDS; ++level)
+    {
+        if (name == names[level])
+        {
+            return static_cast<LogLevel>(level);
+        }
+    }
+    throw runtime_error("Unknown log level: " + name + " (expected none, result, moves or boards)");
+}
+
+struct Tally
+{
+    uint64_t a_wins = 0, b_wins = 0, draws = 0, white_wins = 0, black_wins = 0;
+};
+
+unique_ptr<Player> make_player(const string& name, Team team, unsigned seed, const TournamentOptions& options)
+{
+    if (name == "random")
+    {
+        return unique_ptr<Player>(new RandomPlayer(team, seed));
+    }
+    if (name == "capture")
+    {
+        return unique_ptr<Player>(new CapturePlayer(team, seed));
+    }
+    if (name == "checkmate")
+    {
+        return unique_ptr<Player>(new CheckMateCapturePlayer(team, seed));
+    }
+    if (name == "search")
+    {
+        SearchLimits limits;
+        limits.milliseconds = options.search_milliseconds;
+        limits.tablebases = options.tablebases;
+        return unique_ptr<Player>(new SearchPlayer(team, limits, 4));
+    }
+    if (name == "mcts")
+    {
+        MctsLimits limits;
+        limits.milliseconds = options.search_milliseconds;
+        return unique_ptr<Player>(new MctsPlayer(team, limits, 1 << 16, seed));
+    }
+    throw runtime_error("Unknown player: " + name + " (expected random, capture, checkmate, search or mcts)");
+}
+
+// Mixes the tournament seed and the game number into a seed for one player.
+unsigned game_seed(unsigned seed, unsigned game, unsigned player)
+{
+    uint64_t x = (uint64_t(seed) << 32 | uint64_t(game) << 1 | player) + 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return static_cast<unsigned>(x ^ (x >> 31));
+}
+
+// make_player, playing from book first unless it's empty.
+unique_ptr<Player> make_book_player(const string& name, Team team, unsigned seed, const TournamentOptions& options,
+                                    const OpeningBook& book)
+{
+    unique_ptr<Player> player = make_player(name, team, seed, options);
+    if (book.empty())
+    {
+        return player;
+    }
+    return unique_ptr<Player>(new BookPlayer(book, move(player)));
+}
+
+void play_games(size_t worker, WorkStealingScheduler& scheduler, const TournamentOptions& options, const OpeningBook& book,
+                Tally& tally, mutex& cout_lock)
+{
+    GameLog log(cout, options.log_level, 1 << 20, &cout_lock);
+    int game;
+    while (scheduler.next_task(worker, game))
+    {
+        bool a_is_white = game % 2 == 0;
+        unique_ptr<Player> a = make_book_player(options.player_a, a_is_white ? WHITE : BLACK, game_seed(options.seed, static_cast<unsigned>(game), 0), options, book);
+        unique_ptr<Player> b = make_book_player(options.player_b, a_is_white ? BLACK : WHITE, game_seed(options.seed, static_cast<unsigned>(game), 1), options, book);
+        Team winner = a_is_white
+            ? play_one_chess_game(*a, *b, log, options.max_turns)
+            : play_one_chess_game(*b, *a, log, options.max_turns);
+        if (winner == NONE)
+        {
+            ++tally.draws;
+            continue;
+        }
+        ++(winner == WHITE ? tally.white_wins : tally.black_wins);
+        ++((winner == WHITE) == a_is_white ? tally.a_wins : tally.b_wins);
+    }
+}
+
+TournamentOptions parse_options(int argc, const char* argv[])
+{
+    if (argc < 4)
+    {
+        throw runtime_error(string("Usage: ") + argv[0] + " <games> <player a> <player b> [--threads N] [--seed S] [--max-turns T] [--search-ms M] [--log none|result|moves|boards] [--book FILE] [--tablebases DIRECTORY]");
+    }
+    TournamentOptions options;
+    options.games = stoi(argv[1]);
+    options.player_a = argv[2];
+    options.player_b = argv[3];
+    for (int i = 4; i < argc; i += 2)
+    {
+        if (strncmp(argv[i], "--", 2) != 0)
+        {
+            throw runtime_error(string("Unexpected argument: ") + argv[i]);
+        }
+        if (i + 1 == argc)
+        {
+            throw runtime_error(string("Missing value for ") + argv[i]);
+        }
+        const char* value = argv[i + 1];
+        if (strcmp(argv[i], "--log") == 0)
+        {
+            options.log_level = parse_log_level(value);
+        }
+        else if (strcmp(argv[i], "--book") == 0)
+        {
+            options.book_path = value;
+        }
+        else if (strcmp(argv[i], "--tablebases") == 0)
+        {
+            options.tablebase_directory = value;
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            int threads = stoi(value);
+            if (threads < 1)
+            {
+                throw runtime_error("Need at least one thread");
+            }
+            options.threads = static_cast<size_t>(threads);
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            options.seed = static_cast<unsigned>(stoi(value));
+        }
+        else if (strcmp(argv[i], "--max-turns") == 0)
+        {
+            options.max_turns = stoi(value);
+        }
+        else if (strcmp(argv[i], "--search-ms") == 0)
+        {
+            options.search_milliseconds = stoi(value);
+        }
+        else
+        {
+            throw runtime_error(string("Unknown option: ") + argv[i]);
+        }
+    }
+    if (options.games < 1)
+    {
+        throw runtime_error("Need at least one game");
+    }
+    return options;
+}
+
+int main(int argc, const char* argv[])
+{
+    try
+    {
+        TournamentOptions options = parse_options(argc, argv);
+        // Fail now on unknown player names, rather than on every thread.
+        make_player(options.player_a, WHITE, 0, options);
+        make_player(options.player_b, BLACK, 0, options);
+
+        // One mapping of the book, shared by every thread.
+        OpeningBook empty_book;
+        unique_ptr<OpeningBook> opened_book;
+        if (!options.book_path.empty())
+        {
+            opened_book.reset(new OpeningBook(options.book_path));
+        }
+        const OpeningBook& book = opened_book ? *opened_book : empty_book;
+        unique_ptr<Tablebases> tablebases;
+        if (!options.tablebase_directory.empty())
+        {
+            tablebases.reset(new Tablebases(options.tablebase_directory));
+            options.tablebases = tablebases.get();
+        }
+
+        WorkStealingScheduler scheduler(options.threads, options.games);
+        vector<Tally> tallies(options.threads);
+        vector<thread> workers;
+        mutex cout_lock;
+        auto start = chrono::steady_clock::now();
+        for (size_t worker = 0; worker < options.threads; ++worker)
+        {
+            workers.emplace_back(play_games, worker, ref(scheduler), cref(options), cref(book), ref(tallies[worker]), ref(cout_lock));
+        }
+        Tally total;
+        for (size_t worker = 0; worker < options.threads; ++worker)
+        {
+            workers[worker].join();
+            total.a_wins += tallies[worker].a_wins;
+            total.b_wins += tallies[worker].b_wins;
+            total.draws += tallies[worker].draws;
+            total.white_wins += tallies[worker].white_wins;
+            total.black_wins += tallies[worker].black_wins;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << options.games << " games of " << options.player_a << " (a) vs " << options.player_b
+             << " (b) on " << options.threads << " threads\n"
+             << "a wins: " << total.a_wins << "  b wins: " << total.b_wins << "  draws: " << total.draws << '\n'
+             << "white wins: " << total.white_wins << "  black wins: " << total.black_wins << '\n'
+             << seconds << "s (" << options.games / seconds << " games/s)" << endl;
+        return 0;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "chess_board.h"
+#include "transposition_table.h"
+
+using std::max;
+using std::min;
+
+// How a TableEntry is packed into 64 bits:
+// | bits  0-15 | best move as a PackedMove (all zero for none)
+// | bits 16-23 | depth (0 to 255)
+// | bits 24-25 | bound
+// | bits 32-63 | score
+uint64_t TranspositionTable::pack(int depth, int score, Bound bound, const Move* best_move)
+{
+    uint64_t data = 0;
+    if (best_move)
+    {
+        data |= PackedMove(*best_move).bits;
+    }
+    data |= uint64_t(min(max(depth, 0), 255)) << 16;
+    data |= uint64_t(bound) << 24;
+    data |= uint64_t(uint32_t(int32_t(score))) << 32;
+    return data;
+}
+
+TableEntry TranspositionTable::unpack(uint64_t data)
+{
+    TableEntry entry;
+    PackedMove best_move;
+    best_move.bits = static_cast<uint16_t>(data & 0xFFFF);
+    entry.has_best_move = !best_move.empty();
+    if (entry.has_best_move)
+    {
+        entry.best_move = best_move.move();
+    }
+    entry.depth = (data >> 16) & 255;
+    entry.bound = static_cast<Bound>((data >> 24) & 3);
+    entry.score = int32_t(uint32_t(data >> 32));
+    return entry;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) : slots()
+{
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t max_buckets = megabytes * 1024 * 1024 / (sizeof(Slot) * BUCKET_SIZE);
+    num_buckets = 1;
+    while (num_buckets * 2 <= max_buckets)
+    {
+        num_buckets *= 2;
+    }
+    slots.reset(new Slot[num_buckets * BUCKET_SIZE]);
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < num_buckets * BUCKET_SIZE; ++i)
+    {
+        slots[i].key_xor_data.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::probe(uint64_t hash, TableEntry& entry) const
+{
+    const Slot* bucket = &slots[(hash & (num_buckets - 1)) * BUCKET_SIZE];
+    for (size_t i = 0; i < BUCKET_SIZE; ++i)
+    {
+        uint64_t data = bucket[i].data.load(std::memory_order_relaxed);
+        uint64_t key_xor_data = bucket[i].key_xor_data.load(std::memory_order_relaxed);
+        if ((key_xor_data ^ data) == hash)
+        {
+            entry = unpack(data);
+            if (entry.bound != BOUND_NONE)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t hash, int depth, int score, Bound bound, const Move* best_move)
+{
+    Slot* bucket = &slots[(hash & (num_buckets - 1)) * BUCKET_SIZE];
+    uint64_t data = pack(depth, score, bound, best_move);
+
+    // The first slot keeps whichever result searched deepest (or the newest
+    // result for the same position). Everything else goes in the second slot.
+    uint64_t old_data = bucket[0].data.load(std::memory_order_relaxed);
+    uint64_t old_key = bucket[0].key_xor_data.load(std::memory_order_relaxed) ^ old_data;
+    Slot& slot = (old_key == hash || int((old_data >> 16) & 255) <= depth) ? bucket[0] : bucket[1];
+    if (!best_move && old_key == hash)
+    {
+        // Keep the best move we already knew about.
+        data |= old_data & 0xFFFF;
+    }
+    slot.key_xor_data.store(hash ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
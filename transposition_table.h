@@ -0,0 +1,74 @@
+#ifndef _TRANSPOSITION_TABLE_H_
+#define _TRANSPOSITION_TABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "chess_board.h"
+
+// What a stored score tells us about the real score of a position.
+enum Bound
+{
+    BOUND_NONE,
+    BOUND_UPPER, // the search failed low, the real score is at most score
+    BOUND_LOWER, // the search failed high, the real score is at least score
+    BOUND_EXACT
+};
+
+// What a search found out about a position.
+struct TableEntry
+{
+    int depth = 0;
+    int score = 0;
+    Bound bound = BOUND_NONE;
+    bool has_best_move = false;
+    Move best_move{};
+};
+
+// A fixed-size hash table of search results, keyed by Board::hash().
+//
+// Several search threads can share one table without locks. Each slot is a
+// pair of 64 bit words: the packed entry and (hash XOR packed entry). Both
+// words are written and read separately, so another thread can tear a slot in
+// half, but then the XOR no longer matches the hash and probe treats the slot
+// as a miss instead of returning a mix of two positions.
+class TranspositionTable
+{
+public:
+    // Uses at most megabytes of memory (rounded down to a power of two slots).
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    // Throws away everything and changes the memory budget. Not safe to call
+    // while other threads use the table.
+    void resize(size_t megabytes);
+    // Throws away everything. Not safe to call while other threads use the table.
+    void clear();
+
+    // Returns true and fills in entry if the table has a result for hash.
+    bool probe(uint64_t hash, TableEntry& entry) const;
+    void store(uint64_t hash, int depth, int score, Bound bound, const Move* best_move);
+
+    // The number of entries the table can hold.
+    size_t capacity() const { return num_buckets * BUCKET_SIZE; }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> key_xor_data;
+        std::atomic<uint64_t> data;
+    };
+
+    // Each hash maps to a bucket of two slots. The first keeps the deepest
+    // result, the second always takes the newest one.
+    static constexpr size_t BUCKET_SIZE = 2;
+
+    static uint64_t pack(int depth, int score, Bound bound, const Move* best_move);
+    static TableEntry unpack(uint64_t data);
+
+    std::unique_ptr<Slot[]> slots;
+    size_t num_buckets = 0;
+};
+
+#endif // _TRANSPOSITION_TABLE_H_
@@ -13,23 +13,31 @@ UTF8CodePoint::operator char32_t() const {
 // |           U+0080 | 110xxxxx | 10xxxxxx |          |          |
 // |           U+0800 | 1110xxxx | 10xxxxxx | 10xxxxxx |          |
 // |          U+10000 | 11110xxx | 10xxxxxx | 10xxxxxx | 10xxxxxx |
-ostream& operator<<(ostream& os, const UTF8CodePoint cp) {
-  if (cp.code_point < 0x80) {
-    os.put(cp.code_point);
-  } else if (cp.code_point < 0x800) {
-    os.put(0b1100'0000 | (cp.code_point >> 6 & 0b0001'1111));
-    os.put(0b1000'0000 | (cp.code_point      & 0b0011'1111));
-  } else if (cp.code_point < 0x10000) {
-    os.put(0b1110'0000 | (cp.code_point >> 12 & 0b0000'1111));
-    os.put(0b1000'0000 | (cp.code_point >>  6 & 0b0011'1111));
-    os.put(0b1000'0000 | (cp.code_point       & 0b0011'1111));
-  } else {  // if (cp.code_point < 0x200000)
-    os.put(0b1111'0000 | (cp.code_point >> 18 & 0b0000'0111));
-    os.put(0b1000'0000 | (cp.code_point >> 12 & 0b0011'1111));
-    os.put(0b1000'0000 | (cp.code_point >>  6 & 0b0011'1111));
-    os.put(0b1000'0000 | (cp.code_point       & 0b0011'1111));
+int UTF8CodePoint::encode(char* bytes) const {
+  if (code_point < 0x80) {
+    bytes[0] = code_point;
+    return 1;
+  } else if (code_point < 0x800) {
+    bytes[0] = 0b1100'0000 | (code_point >> 6 & 0b0001'1111);
+    bytes[1] = 0b1000'0000 | (code_point      & 0b0011'1111);
+    return 2;
+  } else if (code_point < 0x10000) {
+    bytes[0] = 0b1110'0000 | (code_point >> 12 & 0b0000'1111);
+    bytes[1] = 0b1000'0000 | (code_point >>  6 & 0b0011'1111);
+    bytes[2] = 0b1000'0000 | (code_point       & 0b0011'1111);
+    return 3;
+  } else {  // if (code_point < 0x200000)
+    bytes[0] = 0b1111'0000 | (code_point >> 18 & 0b0000'0111);
+    bytes[1] = 0b1000'0000 | (code_point >> 12 & 0b0011'1111);
+    bytes[2] = 0b1000'0000 | (code_point >>  6 & 0b0011'1111);
+    bytes[3] = 0b1000'0000 | (code_point       & 0b0011'1111);
+    return 4;
   }
-  return os;
+}
+
+ostream& operator<<(ostream& os, const UTF8CodePoint cp) {
+  char bytes[4];
+  return os.write(bytes, cp.encode(bytes));
 }
 
 
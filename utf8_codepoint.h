@@ -18,6 +18,10 @@ public:
 
   operator char32_t() const;
 
+  // Writes the UTF-8 bytes of this code point to bytes (which needs room for
+  // 4) and returns how many there are.
+  int encode(char* bytes) const;
+
   friend ostream& operator<<(ostream& os, const UTF8CodePoint cp);
   friend istream& operator>>(istream& is, UTF8CodePoint& cp);
 };